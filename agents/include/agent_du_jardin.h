@@ -2,11 +2,12 @@
 
 #include "ai_agent_base.h"
 #include "bitboard.h"
+#include "search_clock.h"
+#include "transposition_table.h"
 #include <algorithm>
 #include <chrono>
 #include <limits>
 #include <random>
-#include <unordered_map>
 #include <vector>
 
 class Board;
@@ -21,24 +22,29 @@ public:
                                   std::chrono::milliseconds timeLimit =
                                       std::chrono::milliseconds(1000)) override;
 
+  // Keeps the transposition table from earlier games; see
+  // TranspositionTable::newGame
+  void onGameStart() override;
+
 private:
   int maxDepth;
-
-  double bitboardMinMax(BitBoard &bitboard, int depth, double alpha,
-                        double beta, bool isBlack, bool isMaximizing,
-                        std::chrono::steady_clock::time_point startTime,
-                        std::chrono::milliseconds timeLimit);
-
-  double evaluateBitboard(const BitBoard &bitboard, bool isBlack) const;
-  double evaluateCornerControlBitboard(const BitBoard &bitboard,
-                                       bool isBlack) const;
-  double evaluateEdgeControlBitboard(const BitBoard &bitboard,
-                                     bool isBlack) const;
-  double evaluateMobilityBitboard(const BitBoard &bitboard, bool isBlack) const;
-  double evaluateStabilityBitboard(const BitBoard &bitboard,
-                                   bool isBlack) const;
-  double evaluateDiscCountBitboard(const BitBoard &bitboard,
-                                   bool isBlack) const;
+  // Only cache positions once the game has left the opening
+  bool phase2 = false;
+  SearchClock clock;
+
+  Score bitboardMinMax(BitBoard &bitboard, int depth, Score alpha,
+                       Score beta, bool isBlack, bool isMaximizing);
+
+  Score evaluateBitboard(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluateCornerControlBitboard(const BitBoard &bitboard,
+                                      bool isBlack) const;
+  Score evaluateEdgeControlBitboard(const BitBoard &bitboard,
+                                    bool isBlack) const;
+  Score evaluateMobilityBitboard(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluateStabilityBitboard(const BitBoard &bitboard,
+                                  bool isBlack) const;
+  Score evaluateDiscCountBitboard(const BitBoard &bitboard,
+                                  bool isBlack) const;
 
   int computeDepth(const BitBoard &bitboard, bool isBlack) const;
 
@@ -74,43 +80,29 @@ private:
     return (C_SQUARES & (1ULL << (r * 8 + c))) != 0;
   }
 
-  enum class EntryType { EXACT, LOWER_BOUND, UPPER_BOUND };
-  struct TranspositionEntry {
-    uint64_t hash;
-    double score;
-    int depth;
-    EntryType type;
-    bool isMaximizing;
-    std::chrono::steady_clock::time_point timestamp;
-    TranspositionEntry()
-        : hash(0), score(0.0), depth(-1), type(EntryType::EXACT),
-          isMaximizing(true) {}
-    TranspositionEntry(uint64_t h, double s, int d, EntryType t, bool b)
-        : hash(h), score(s), depth(d), type(t), isMaximizing(b) {}
-  };
+  using EntryType = TTBound;
   struct Etat {
     BitBoard bitboard;
     bool isMaximizing;
     Etat(BitBoard bb, bool b) : bitboard(bb), isMaximizing(b) {}
   };
-  // mutable std::unordered_map<uint64_t,TranspositionEntry> transpositionTable;
-  mutable std::unordered_map<uint64_t, std::array<TranspositionEntry, 2>>
-      transpositionTable;
-  static constexpr size_t MAX_TRANSPOSITION_SIZE = 4000000;
+  static constexpr size_t TT_MEGABYTES = 32;
+  mutable TranspositionTable transpositionTable{TT_MEGABYTES};
+  // Maximizing and minimizing nodes of a position get separate entries,
+  // and so do the two colours, scores being from the root player's side
+  static constexpr uint64_t MAXIMIZING_KEY = 0x9E3779B97F4A7C15ULL;
+  static constexpr uint64_t BLACK_ROOT_KEY = 0xC2B2AE3D27D4EB4FULL;
+  // Stores unless the clock has cut the search short
+  void ttStore(uint64_t hash, Score score, int depth, EntryType type);
 
   uint64_t getZobristHash(const BitBoard &bitboard) const;
-  void clearTranspositionTable();
   size_t getTranspositionTableSize() const;
 
   bool isBlackPlayer(CellState player) const;
   CellState playerFromBool(bool isBlack) const;
 
-  std::vector<std::pair<int, int>>
-  orderMoves(const BitBoard &bitboard,
-             const std::vector<std::pair<int, int>> &moves, bool isBlack) const;
-
-  bool isTimeUpLarge(std::chrono::steady_clock::time_point startTime,
-                     std::chrono::milliseconds timeLimit) const;
+  void orderMoves(const BitBoard &bitboard, MoveList &moves,
+                  bool isBlack) const;
 
   // Quiescence search placeholder (not implemented yet)
   // double quiescenceSearch(BitBoard& bitboard, double alpha, double beta,
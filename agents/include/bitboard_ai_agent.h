@@ -2,9 +2,15 @@
 
 #include "ai_agent_base.h"
 #include "bitboard.h"
+#include "search_clock.h"
+#include "task_pool.h"
+#include "transposition_table.h"
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <unordered_map>
 #include <vector>
@@ -14,75 +20,100 @@ enum class CellState;
 
 class BitBoardAIAgent : public AIAgentBase {
 public:
+  // threads > 1 searches in parallel, splitting nodes Young Brothers Wait
+  // style over a work-stealing pool
   BitBoardAIAgent(const std::string &name = "BitBoard",
-                  const std::string &author = "System", int maxDepth = 8);
+                  const std::string &author = "System", int maxDepth = 8,
+                  int threads = 1);
 
   std::pair<int, int> getBestMove(const Board &board, CellState player,
                                   std::chrono::milliseconds timeLimit =
                                       std::chrono::milliseconds(1000)) override;
 
+  // Keeps the transposition table from earlier games; see
+  // TranspositionTable::newGame
+  void onGameStart() override;
+
+  // Nodes visited by the last getBestMove, all threads together
+  uint64_t getLastSearchNodes() const;
+  // How the transposition table is backed, for judging TLB pressure
+  LargePageBuffer::Stats getTableMemoryStats() const {
+    return transpositionTable.memoryStats();
+  }
+
 private:
   int maxDepth;
+  SearchClock clock;
+
+  // Parallel search. Once a node's first child is searched without a
+  // cutoff, its younger brothers become tasks any thread may take. They
+  // share the node's window through a SplitPoint, and a cutoff in one
+  // cancels the rest, along with every split point below them.
+  static constexpr int MIN_SPLIT_DEPTH = 3;
+  int threads;
+  std::unique_ptr<TaskPool> pool;
+  // Clocks of pool threads 1 to n - 1; the per-node countdown is not
+  // thread-safe, so each thread checks time on its own
+  std::unique_ptr<SearchClock[]> workerClocks;
+
+  struct SplitPoint {
+    const SplitPoint *parent = nullptr;
+    std::atomic<bool> cancelled{false};
+    std::mutex mutex;
+    Score alpha = 0;
+    Score beta = 0;
+    Score best = 0;
+    bool cutoff = false;
+    bool interrupted = false;
+  };
+  static bool isCancelled(const SplitPoint *splitPoint);
+  SearchClock &clockFor(int thread);
 
-  double bitboardMinMax(BitBoard &bitboard, int depth, double alpha,
-                        double beta, bool isBlack, bool isMaximizing,
-                        std::chrono::steady_clock::time_point startTime,
-                        std::chrono::milliseconds timeLimit);
-
-  double evaluateBitboard(const BitBoard &bitboard, bool isBlack) const;
-  double evaluateCornerControlBitboard(const BitBoard &bitboard,
-                                       bool isBlack) const;
-  double evaluateEdgeControlBitboard(const BitBoard &bitboard,
-                                     bool isBlack) const;
-  double evaluateMobilityBitboard(const BitBoard &bitboard, bool isBlack) const;
-  double evaluateStabilityBitboard(const BitBoard &bitboard,
-                                   bool isBlack) const;
-  double evaluateDiscCountBitboard(const BitBoard &bitboard,
-                                   bool isBlack) const;
+  Score bitboardMinMax(BitBoard &bitboard, int depth, Score alpha, Score beta,
+                       bool isBlack, bool isMaximizing,
+                       SearchClock &searchClock, const SplitPoint *parent);
+  // Searches moves 1.. of a node in parallel, updating best; returns
+  // whether the search was interrupted
+  bool searchYoungerBrothers(const BitBoard &bitboard, const MoveList &moves,
+                             int depth, Score alpha, Score beta,
+                             bool isBlack, bool isMaximizing, Score &best,
+                             bool &cutoff, const SplitPoint *parent);
+
+  Score evaluateBitboard(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluateCornerControlBitboard(const BitBoard &bitboard,
+                                      bool isBlack) const;
+  Score evaluateEdgeControlBitboard(const BitBoard &bitboard,
+                                    bool isBlack) const;
+  Score evaluateMobilityBitboard(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluateStabilityBitboard(const BitBoard &bitboard,
+                                  bool isBlack) const;
+  Score evaluateDiscCountBitboard(const BitBoard &bitboard,
+                                  bool isBlack) const;
 
   static const std::array<std::array<int, 8>, 8> POSITION_VALUES;
   static const std::array<std::array<int, 8>, 8> EARLY_GAME_VALUES;
   static const std::array<std::array<int, 8>, 8> LATE_GAME_VALUES;
 
-  enum class EntryType { EXACT, LOWER_BOUND, UPPER_BOUND };
-  struct TranspositionEntry {
-    uint64_t hash;
-    double score;
-    int depth;
-    EntryType type;
-    std::chrono::steady_clock::time_point timestamp;
-    TranspositionEntry()
-        : hash(0), score(0.0), depth(0), type(EntryType::EXACT) {}
-    TranspositionEntry(uint64_t h, double s, int d, EntryType t)
-        : hash(h), score(s), depth(d), type(t) {}
-  };
-  static constexpr size_t TT_WAYS = 4;
-  static constexpr size_t TT_NUM_BUCKETS = 1 << 20;
-  struct TTBucket {
-    TranspositionEntry entries[TT_WAYS];
-  };
-  mutable std::vector<TTBucket> transpositionTable;
-  static_assert(TT_WAYS >= 2, "TT must be at least 2-way associative");
+  // Shared by the parallel search's threads
+  using EntryType = TTBound;
+  using TTEntry = TranspositionTable::Entry;
+  static constexpr size_t TT_MEGABYTES = 64;
+  // Scores are from the root player's side, so the table keeps the two
+  // colours' entries apart and stays valid when the agent switches sides
+  static constexpr uint64_t BLACK_ROOT_KEY = 0xC2B2AE3D27D4EB4FULL;
+  mutable TranspositionTable transpositionTable{TT_MEGABYTES};
 
   uint64_t getZobristHash(const BitBoard &bitboard, bool blackToMove) const;
-  void clearTranspositionTable();
   size_t getTranspositionTableSize() const;
 
-  inline size_t ttBucketIndex(uint64_t hash) const {
-    return static_cast<size_t>(hash % TT_NUM_BUCKETS);
-  }
-  const TranspositionEntry *ttLookup(uint64_t hash, int requiredDepth) const;
-  void ttStore(uint64_t hash, double score, int depth, EntryType type) const;
+  bool ttLookup(uint64_t hash, int requiredDepth, TTEntry &entry) const;
+  void ttStore(uint64_t hash, Score score, int depth, EntryType type) const;
 
   bool isBlackPlayer(CellState player) const;
   CellState playerFromBool(bool isBlack) const;
 
-  std::vector<std::pair<int, int>>
-  orderMoves(const BitBoard &bitboard,
-             const std::vector<std::pair<int, int>> &moves, bool isBlack) const;
-
-protected:
-  bool isTimeUp(std::chrono::steady_clock::time_point startTime,
-                std::chrono::milliseconds timeLimit =
-                    std::chrono::milliseconds(1000)) const;
+  // Also prefetches the children's table entries, keyed for a search by
+  // rootIsBlack
+  void orderMoves(const BitBoard &bitboard, MoveList &moves, bool isBlack,
+                  bool rootIsBlack) const;
 };
@@ -2,32 +2,60 @@
 
 #include "ai_agent_base.h"
 #include "bitboard.h"
+#include "large_page_buffer.h"
+#include "search_clock.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <random>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
 namespace mcts {
 
+// Index of the k-th set bit of mask, counting from the least significant bit.
+// k must be smaller than the population count of mask.
+inline int nth_set_bit(uint64_t mask, unsigned int k) {
+#ifdef __BMI2__
+  return __builtin_ctzll(_pdep_u64(1ULL << k, mask));
+#else
+  int base = 0;
+  for (int width = 32; width >= 8; width /= 2) {
+    unsigned int low = __builtin_popcountll(mask & ((1ULL << width) - 1));
+    if (k >= low) {
+      k -= low;
+      mask >>= width;
+      base += width;
+    }
+  }
+  for (; k > 0; --k) {
+    mask &= mask - 1;
+  }
+  return base + __builtin_ctzll(mask);
+#endif
+}
+
+inline int random_bit(uint64_t mask, std::minstd_rand &rng) {
+  return nth_set_bit(mask, rng() % __builtin_popcountll(mask));
+}
+
 class Game {
 public:
   using Move = std::pair<int, int>;
   using ValidMoves = std::vector<Move>;
   explicit Game(const Board &board, CellState player)
-      : next_player_(player == CellState::BLACK), winner_(-1) {
-    for (int row = 0; row < 8; ++row) {
-      for (int col = 0; col < 8; ++col) {
-        CellState cell = board.getCell(row, col);
-        if (cell == CellState::BLACK) {
-          bitboard_.setCell(row, col, 1);
-        } else if (cell == CellState::WHITE) {
-          bitboard_.setCell(row, col, 2);
-        }
-      }
-    }
+      : bitboard_(board.toBitBoard()), next_player_(player == CellState::BLACK),
+        winner_(-1) {
     if (bitboard_.isGameOver()) {
       compute_winner();
     }
@@ -35,27 +63,23 @@ public:
   bool next_player() const { return next_player_; }
   bool finished() const { return 0 <= winner_; }
   int winner() const { return winner_; }
+  const BitBoard &bitboard() const { return bitboard_; }
   ValidMoves valid_moves() const {
     return bitboard_.getValidMoves(next_player_);
   }
   int random_play(std::minstd_rand &rng) {
     while (!finished()) {
-      ValidMoves vmoves = valid_moves();
-      std::uniform_int_distribution<unsigned int> dist(0u, vmoves.size() - 1);
-      play(vmoves[dist(rng)]);
+      play(random_bit(bitboard_.legalMovesMask(next_player_), rng));
     }
     return winner();
   }
-  void play(Move move) {
-    bitboard_.makeMove(move.first, move.second, next_player_);
-    bool bcp = bitboard_.hasValidMoves(1);
-    bool wcp = bitboard_.hasValidMoves(0);
-    if (!bcp && !wcp) {
+  void play(Move move) { play(move.first * 8 + move.second); }
+  void play(int bit) {
+    bitboard_.makeMoveUnchecked(bit, next_player_);
+    if (bitboard_.legalMovesMask(!next_player_)) {
+      next_player_ = !next_player_;
+    } else if (!bitboard_.legalMovesMask(next_player_)) {
       compute_winner();
-    } else if (next_player_ && wcp) {
-      next_player_ = false;
-    } else if (!next_player_ && bcp) {
-      next_player_ = true;
     }
   }
 
@@ -75,115 +99,517 @@ private:
   bool next_player_;
   int winner_;
 };
+
+// Plays several random games from the same position in lockstep so that move
+// generation and flipping run through the batched BitBoard kernels. Finished
+// games are swapped out of the active range, keeping the lanes contiguous.
+class PlayoutBatch {
+public:
+  static constexpr int MAX_LANES = 16;
+
+  // Returns the summed score for black over `lanes` playouts (1 for a win,
+  // 0.5 for a draw).
+  double run(const Game &game, int lanes, std::minstd_rand &rng) {
+    if (game.finished()) {
+      return lanes * outcome(game.winner());
+    }
+    const BitBoard &board = game.bitboard();
+    bool black = game.next_player();
+    int active = lanes;
+    for (int i = 0; i < active; ++i) {
+      player_[i] = board.getPlayerBoard(black);
+      opponent_[i] = board.getPlayerBoard(!black);
+      black_[i] = black;
+    }
+    double score = 0;
+    while (active > 0) {
+      BitBoard::legalMovesMaskBatch(player_, opponent_, moves_, active);
+      for (int i = 0; i < active;) {
+        if (moves_[i] == 0) {
+          uint64_t reply = BitBoard::legalMovesMask(opponent_[i], player_[i]);
+          if (reply == 0) {
+            score += lane_score(i);
+            remove_lane(i, --active);
+            continue;
+          }
+          std::swap(player_[i], opponent_[i]);
+          black_[i] = !black_[i];
+          moves_[i] = reply;
+        }
+        picks_[i] = 1ULL << random_bit(moves_[i], rng);
+        ++i;
+      }
+      BitBoard::flipsMaskBatch(picks_, player_, opponent_, flips_, active);
+      for (int i = 0; i < active; ++i) {
+        uint64_t player = player_[i] | picks_[i] | flips_[i];
+        player_[i] = opponent_[i] ^ flips_[i];
+        opponent_[i] = player;
+        black_[i] = !black_[i];
+      }
+    }
+    return score;
+  }
+
+private:
+  static double outcome(int winner) {
+    return winner == 1 ? 1.0 : winner == 0 ? 0.5 : 0.0;
+  }
+  double lane_score(int i) const {
+    int mine = __builtin_popcountll(player_[i]);
+    int theirs = __builtin_popcountll(opponent_[i]);
+    int sb = black_[i] ? mine : theirs;
+    int sw = black_[i] ? theirs : mine;
+    return sb > sw ? 1.0 : sb == sw ? 0.5 : 0.0;
+  }
+  void remove_lane(int i, int last) {
+    player_[i] = player_[last];
+    opponent_[i] = opponent_[last];
+    moves_[i] = moves_[last];
+    black_[i] = black_[last];
+  }
+  uint64_t player_[MAX_LANES];
+  uint64_t opponent_[MAX_LANES];
+  uint64_t moves_[MAX_LANES];
+  uint64_t picks_[MAX_LANES];
+  uint64_t flips_[MAX_LANES];
+  bool black_[MAX_LANES];
+};
+// Monte Carlo tree search, optionally tree-parallel: `threads` threads grow
+// one shared tree. A thread descending through a node adds a virtual loss to
+// it until its playout is backed up, steering the other threads towards
+// different lines.
+//
+// Nodes live in a fixed pool addressed by 32-bit index, split by use: the
+// statistics read on every selection step in one array, the move leading to
+// each node in another. A node's children are allocated together, the first
+// time a search passes through it, as one contiguous block taken from the
+// pool with an atomic bump; the node keeps only the index of the first
+// child, and the position gives the count. Nothing is allocated per node.
 class Mcts {
+  struct Stats {
+    std::atomic<int32_t> visits;
+    // Black's score, counted in half points so draws stay integral
+    std::atomic<int32_t> half_score;
+    // Index of the first child, 0 until the children are allocated
+    std::atomic<uint32_t> first_child;
+  };
+
 public:
-  using time_point = std::chrono::steady_clock ::time_point;
-  using time_ms = std::chrono::milliseconds;
-  Mcts(unsigned int n_nodes, uint64_t seed) : rng_(seed) {
-    nodes_.reserve(n_nodes);
-  }
-  Game::Move best_move(const Game &game, time_point start, time_ms time_limit) {
-    nodes_.clear();
-    Node *root = new_node(nullptr, game);
-    while (nodes_.size() < nodes_.capacity() && time_left(start, time_limit)) {
-      Game t_game = game;
-      Node *new_node = expand(root, t_game);
-      int winner = t_game.random_play(rng_);
-      double score = 0;
-      if (winner == 1) {
-        score = 1;
-      } else if (winner == 0) {
-        score = 0.5;
+  using RootScores = std::vector<std::pair<Game::Move, double>>;
+
+  // Pool memory per node: its statistics plus its move code
+  static constexpr size_t BYTES_PER_NODE = sizeof(Stats) + sizeof(uint16_t);
+
+  Mcts(uint32_t n_nodes, uint64_t seed, int batch_size = 1, int threads = 1)
+      : batch_size_(std::clamp(batch_size, 1, PlayoutBatch::MAX_LANES)),
+        virtual_loss_(threads > 1 ? batch_size_ : 0),
+        stats_buffer_(sizeof(Stats) * n_nodes, false),
+        moves_buffer_(sizeof(uint16_t) * n_nodes, false),
+        stats_(static_cast<Stats *>(stats_buffer_.data())),
+        moves_(static_cast<uint16_t *>(moves_buffer_.data())),
+        capacity_(n_nodes) {
+    std::uninitialized_default_construct_n(stats_, n_nodes);
+    for (int i = 0; i < std::max(threads, 1); ++i) {
+      workers_.emplace_back(seed + i);
+    }
+  }
+
+  // Empties the tree and faults the pool in again from as many threads as
+  // search it, placing its pages near them; not while a search is running
+  void reset() {
+    int threads = static_cast<int>(workers_.size());
+    stats_buffer_.reset(threads);
+    moves_buffer_.reset(threads);
+    size_.store(0, std::memory_order_relaxed);
+    full_.store(false, std::memory_order_relaxed);
+  }
+
+  // Grows the tree rooted at game. A tree already rooted at the same
+  // position, e.g. from pondering, is extended rather than rebuilt, and one
+  // holding game a few moves below its root keeps that subtree.
+  // Only the thread that owns the clock counts iterations on it; the
+  // others read the time directly, which costs little next to a playout.
+  void search(const Game &game, SearchClock &clock, bool owns_clock = true) {
+    if (!reroot(game)) {
+      size_.store(0, std::memory_order_relaxed);
+      full_.store(false, std::memory_order_relaxed);
+      allocate(1);
+      root_ = game;
+    }
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < workers_.size(); ++i) {
+      helpers.emplace_back([this, &game, &clock, i]() {
+        grow(game, clock, false, workers_[i]);
+      });
+    }
+    grow(game, clock, owns_clock, workers_[0]);
+    for (auto &helper : helpers) {
+      helper.join();
+    }
+  }
+
+  // Scores of the root's visited children for player, to pick a move or
+  // merge with other trees
+  RootScores root_scores(bool player) const {
+    RootScores scores;
+    uint32_t first = stats_[0].first_child.load(std::memory_order_acquire);
+    if (size_.load(std::memory_order_relaxed) == 0 || first == 0)
+      return scores;
+    for (uint32_t i = first, end = first + child_count(root_); i < end; ++i) {
+      if (stats_[i].visits.load(std::memory_order_relaxed) > 0) {
+        scores.emplace_back(to_move(moves_[i]), get_score(stats_[i], player));
       }
-      backpropagate(new_node, score);
     }
-    Game::Move best_move;
-    double best_score = -std::numeric_limits<double>::infinity();
-    for (unsigned int i = 0, c = root->moves.size(); i < c; ++i) {
-      Node *child = root->children[i];
-      if (child == nullptr) {
+    return scores;
+  }
+
+  // The most visited reply to move in the current tree, if it has one
+  bool predicted_reply(Game::Move move, Game::Move &reply) const {
+    uint32_t first = stats_[0].first_child.load(std::memory_order_acquire);
+    if (size_.load(std::memory_order_relaxed) == 0 || first == 0)
+      return false;
+    for (uint32_t i = first, end = first + child_count(root_); i < end; ++i) {
+      if (to_move(moves_[i]) != move)
         continue;
+      uint32_t reply_first =
+          stats_[i].first_child.load(std::memory_order_acquire);
+      if (reply_first == 0)
+        return false;
+      Game position = root_;
+      position.play(move);
+      int32_t best_visits = 0;
+      for (uint32_t j = reply_first, e = j + child_count(position); j < e;
+           ++j) {
+        int32_t visits = stats_[j].visits.load(std::memory_order_relaxed);
+        if (visits > best_visits) {
+          best_visits = visits;
+          reply = to_move(moves_[j]);
+        }
       }
-      double child_score = child->get_score(game.next_player());
-      Game::Move move = root->moves[i];
-      if (best_score < child_score) {
-        best_score = child_score;
-        best_move = move;
-      }
+      return best_visits > 0;
     }
-    return best_move;
+    return false;
   }
 
+  // Nodes in the current tree, and the pool memory they take
+  uint32_t node_count() const {
+    return static_cast<uint32_t>(std::min<uint64_t>(
+        size_.load(std::memory_order_relaxed), capacity_));
+  }
+  size_t memory_used() const { return node_count() * BYTES_PER_NODE; }
+  size_t memory_capacity() const { return capacity_ * BYTES_PER_NODE; }
+
 private:
-  static bool time_left(time_point start, time_ms time_limit) {
-    auto now = std::chrono ::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<time_ms>(now - start);
-    return elapsed + time_ms{3u} < time_limit;
-  }
-  struct Node {
-    Node *parent = nullptr;
-    Game::ValidMoves moves;
-    std::vector<Node *> children;
-    double score = 0;
-    double visits = 0;
-    double get_score(bool play) const { return play ? score : visits - score; }
-    double uct(Node *parent, bool play) const {
-      return get_score(play) / visits + 0.2 * std::log(parent->visits / visits);
-    }
+  // One node on the path of a descent, with the side that moved into it
+  struct Step {
+    uint32_t node;
+    bool black_moved;
+  };
+  // Per-thread search state
+  struct Worker {
+    explicit Worker(uint64_t seed) : rng(seed) {}
+    std::minstd_rand rng;
+    PlayoutBatch playouts;
+    std::vector<Step> path;
+  };
+
+  // Live child block found while compacting, and where it moves to
+  struct Block {
+    uint32_t first;
+    uint32_t count;
+    uint32_t owner;
+    uint32_t target;
   };
-  Node *new_node(Node *parent, const Game &game) {
-    nodes_.emplace_back();
-    Node &node = nodes_.back();
-    node.parent = parent;
-    node.moves = game.valid_moves();
-    node.children.resize(node.moves.size(), nullptr);
-    return &node;
-  }
-  Node *expand(Node *parent, Game &game) {
+  // Deepest descendant reroot() looks for: our move, the reply, and a
+  // pass of ours followed by a second reply
+  static constexpr int MAX_REROOT_PLIES = 3;
+
+  static bool same_position(const Game &a, const Game &b) {
+    return a.next_player() == b.next_player() &&
+           a.bitboard().blackBoard == b.bitboard().blackBoard &&
+           a.bitboard().whiteBoard == b.bitboard().whiteBoard;
+  }
+  static Game::Move to_move(uint16_t code) { return {code / 8, code % 8}; }
+  static int child_count(const Game &game) {
+    if (game.finished())
+      return 0;
+    return __builtin_popcountll(
+        game.bitboard().legalMovesMask(game.next_player()));
+  }
+  static double get_score(const Stats &stats, bool play) {
+    double score = stats.half_score.load(std::memory_order_relaxed) * 0.5;
+    return play ? score
+                : stats.visits.load(std::memory_order_relaxed) - score;
+  }
+  static double uct(const Stats &child, double parent_visits, bool play) {
+    double n = child.visits.load(std::memory_order_relaxed);
+    return get_score(child, play) / n + 0.2 * std::log(parent_visits / n);
+  }
+
+  static int disc_count(const Game &game) {
+    return __builtin_popcountll(game.bitboard().blackBoard |
+                                game.bitboard().whiteBoard);
+  }
+
+  // Makes the node for game the root if the tree has one within
+  // MAX_REROOT_PLIES moves of the current root; false if the tree has to
+  // be rebuilt. Must not run while the tree is being searched.
+  bool reroot(const Game &game) {
+    if (size_.load(std::memory_order_relaxed) == 0)
+      return false;
+    if (same_position(root_, game))
+      return true;
+    // Every move adds a disc, so the count tells how deep to look
+    int plies = disc_count(game) - disc_count(root_);
+    if (plies < 1 || plies > MAX_REROOT_PLIES)
+      return false;
+    uint32_t node = find(0, root_, game, plies);
+    if (node == 0)
+      return false;
+    compact(node, game);
+    root_ = game;
+    full_.store(false, std::memory_order_relaxed);
+    return true;
+  }
+  // The node plies moves below node that holds target, 0 if none
+  uint32_t find(uint32_t node, const Game &position, const Game &target,
+                int plies) const {
+    uint32_t first = stats_[node].first_child.load(std::memory_order_relaxed);
+    if (first == 0)
+      return 0;
+    for (uint32_t i = first, end = first + child_count(position); i < end;
+         ++i) {
+      Game next = position;
+      next.play(static_cast<int>(moves_[i]));
+      if (plies == 1) {
+        if (same_position(next, target))
+          return i;
+      } else if (uint32_t found = find(i, next, target, plies - 1)) {
+        return found;
+      }
+    }
+    return 0;
+  }
+  // Keeps only the subtree of root, whose position is given, and slides
+  // it to the front of the pool with root at index 0. Child blocks are
+  // always allocated after their parent, so moving the live blocks down
+  // in address order never overwrites one not yet moved.
+  void compact(uint32_t root, const Game &position) {
+    // The old root is dropped, which frees its slot for the new one
+    copy_node(root, 0);
+    std::vector<Block> blocks;
+    std::vector<std::pair<uint32_t, Game>> pending{{0, position}};
+    while (!pending.empty()) {
+      auto [node, game] = pending.back();
+      pending.pop_back();
+      uint32_t first = stats_[node].first_child.load(std::memory_order_relaxed);
+      if (first == 0)
+        continue;
+      uint32_t count = child_count(game);
+      blocks.push_back({first, count, node, 0});
+      for (uint32_t i = first; i < first + count; ++i) {
+        if (stats_[i].first_child.load(std::memory_order_relaxed) != 0) {
+          Game child = game;
+          child.play(static_cast<int>(moves_[i]));
+          pending.emplace_back(i, child);
+        }
+      }
+    }
+
+    std::sort(blocks.begin(), blocks.end(),
+              [](const Block &a, const Block &b) { return a.first < b.first; });
+    uint32_t size = 1;
+    for (auto &block : blocks) {
+      block.target = size;
+      stats_[block.owner].first_child.store(block.target,
+                                            std::memory_order_relaxed);
+      size += block.count;
+    }
+    for (const auto &block : blocks) {
+      for (uint32_t i = 0; i < block.count; ++i) {
+        copy_node(block.first + i, block.target + i);
+      }
+    }
+    size_.store(size, std::memory_order_relaxed);
+  }
+  void copy_node(uint32_t from, uint32_t to) {
+    if (from == to)
+      return;
+    Stats &source = stats_[from], &dest = stats_[to];
+    dest.visits.store(source.visits.load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+    dest.half_score.store(source.half_score.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+    dest.first_child.store(source.first_child.load(std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+    moves_[to] = moves_[from];
+  }
+
+  void grow(const Game &game, SearchClock &clock, bool owns_clock,
+            Worker &worker) {
+    while (!full_.load(std::memory_order_relaxed) &&
+           !(owns_clock ? clock.timeUp() : clock.hardTimeUp())) {
+      Game t_game = game;
+      worker.path.clear();
+      bool expanded = descend(t_game, worker.path);
+      double score = 0;
+      int visits = 0;
+      if (expanded) {
+        score = worker.playouts.run(t_game, batch_size_, worker.rng);
+        visits = batch_size_;
+      }
+      // Also takes back the virtual loss of a descent the full pool cut off
+      backpropagate(worker.path, score, visits);
+      if (!expanded) {
+        full_.store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+  // First index of count fresh nodes, 0 once the pool is exhausted
+  uint32_t allocate(uint32_t count) {
+    uint64_t first = size_.fetch_add(count, std::memory_order_relaxed);
+    if (first + count > capacity_)
+      return 0;
+    for (uint64_t i = first; i < first + count; ++i) {
+      stats_[i].visits.store(0, std::memory_order_relaxed);
+      stats_[i].half_score.store(0, std::memory_order_relaxed);
+      stats_[i].first_child.store(0, std::memory_order_relaxed);
+    }
+    return static_cast<uint32_t>(first);
+  }
+  // Allocates node's children for legal, or returns the block another
+  // thread published first; 0 if the pool is exhausted
+  uint32_t expand(uint32_t node, uint64_t legal, int count) {
+    uint32_t first = allocate(count);
+    if (first == 0)
+      return 0;
+    for (uint32_t i = first; legal; legal &= legal - 1, ++i) {
+      moves_[i] = static_cast<uint16_t>(__builtin_ctzll(legal));
+    }
+    uint32_t expected = 0;
+    if (stats_[node].first_child.compare_exchange_strong(
+            expected, first, std::memory_order_acq_rel)) {
+      return first;
+    }
+    return expected;
+  }
+  // Walks down from the root to a node no playout has reached yet, or to
+  // the end of the game, recording the path. False if the pool is full.
+  bool descend(Game &game, std::vector<Step> &path) {
+    uint32_t node = 0;
+    path.push_back({0, false});
     while (!game.finished()) {
-      unsigned int bmi = 0;
+      bool black = game.next_player();
+      uint64_t legal = game.bitboard().legalMovesMask(black);
+      int count = __builtin_popcountll(legal);
+      uint32_t first = stats_[node].first_child.load(std::memory_order_acquire);
+      if (first == 0) {
+        first = expand(node, legal, count);
+        if (first == 0)
+          return false;
+      }
+
+      double parent_visits = stats_[node].visits.load(std::memory_order_relaxed);
+      uint32_t chosen = first;
+      bool unvisited = false;
       double b_uct = -std::numeric_limits<double>::infinity();
-      unsigned int c = parent->moves.size();
-      for (unsigned int i = 0; i < c; ++i) {
-        Node *child = parent->children[i];
-        if (child == nullptr) {
-          game.play(parent->moves[i]);
-          child = new_node(parent, game);
-          parent->children[i] = child;
-          return child;
+      for (uint32_t i = first, end = first + count; i < end; ++i) {
+        if (stats_[i].visits.load(std::memory_order_relaxed) == 0) {
+          chosen = i;
+          unvisited = true;
+          break;
         }
-        double c_uct = child->uct(parent, game.next_player());
+        double c_uct = uct(stats_[i], parent_visits, black);
         if (b_uct < c_uct) {
-          bmi = i;
+          chosen = i;
           b_uct = c_uct;
         }
       }
-      game.play(parent->moves[bmi]);
-      parent = parent->children[bmi];
+      game.play(static_cast<int>(moves_[chosen]));
+      add_virtual_loss(chosen, black, 1);
+      path.push_back({chosen, black});
+      if (unvisited)
+        break;
+      node = chosen;
+    }
+    return true;
+  }
+  void add_virtual_loss(uint32_t node, bool black_moved, int sign) {
+    if (virtual_loss_ == 0)
+      return;
+    stats_[node].visits.fetch_add(sign * virtual_loss_,
+                                  std::memory_order_relaxed);
+    // A loss for the side that moved here
+    if (!black_moved) {
+      stats_[node].half_score.fetch_add(sign * 2 * virtual_loss_,
+                                        std::memory_order_relaxed);
     }
-    return parent;
   }
-  void backpropagate(Node *child, double score) {
-    while (child != nullptr) {
-      child->score += score;
-      ++child->visits;
-      child = child->parent;
+  void backpropagate(const std::vector<Step> &path, double score,
+                     int visits) {
+    int32_t half_score = static_cast<int32_t>(score * 2);
+    for (size_t i = 0; i < path.size(); ++i) {
+      Stats &stats = stats_[path[i].node];
+      if (i > 0) {
+        add_virtual_loss(path[i].node, path[i].black_moved, -1);
+      }
+      stats.half_score.fetch_add(half_score, std::memory_order_relaxed);
+      stats.visits.fetch_add(visits, std::memory_order_relaxed);
     }
   }
-  std::minstd_rand rng_;
-  std::vector<Node> nodes_;
+
+  int batch_size_;
+  int virtual_loss_;
+  std::vector<Worker> workers_;
+  // Hot and cold halves of the node pool, on huge pages where possible.
+  // Pages are only touched as the tree grows until reset() faults them in.
+  LargePageBuffer stats_buffer_;
+  LargePageBuffer moves_buffer_;
+  Stats *stats_;
+  uint16_t *moves_;
+  uint32_t capacity_;
+  std::atomic<uint64_t> size_{0};
+  std::atomic<bool> full_{false};
+  Game root_{Board(), CellState::BLACK};
 };
 
 } // namespace mcts
 
 class MCTSAiAgent : public AIAgentBase {
 public:
+  // threads > 1 searches in parallel: one shared tree, or with
+  // root_parallel one tree per thread whose root statistics are merged
   MCTSAiAgent(const std::string &name = "MCTS",
-              const std::string &author = "Ulysse");
+              const std::string &author = "Ulysse", int threads = 1,
+              bool root_parallel = false);
+  ~MCTSAiAgent() override;
   std::pair<int, int> getBestMove(const Board &board, CellState player,
                                   std::chrono::milliseconds timeLimit =
                                       std::chrono::milliseconds(1000)) override;
 
+  // Empties the trees, placing their pools for the threads that search them
+  void onGameStart() override;
+  void onMoveMade(int row, int col, CellState player) override;
+  void stopPondering() override;
+
+  // Size of the trees after the last search, all trees together
+  uint64_t getTreeNodes() const;
+  size_t getTreeMemoryUsed() const;
+  size_t getTreeMemoryCapacity() const;
+
 private:
-  mcts::Mcts mcts_;
+  std::vector<std::unique_ptr<mcts::Mcts>> trees_;
+  SearchClock clock_;
+
+  // Grows every tree, each on its own thread, until clock_ stops
+  void search(const mcts::Game &game);
+  mcts::Game::Move pick_move(const mcts::Game &game) const;
+
+  // Background search on the expected reply; on a hit the next move
+  // continues the same tree
+  static constexpr std::chrono::milliseconds PONDER_LIMIT{3600000};
+  std::thread ponder_thread_;
+  mcts::Game::Move ponder_reply_{-1, -1};
+  bool ponder_black_ = false;
+  void start_pondering(const mcts::Game &game, mcts::Game::Move move);
 };
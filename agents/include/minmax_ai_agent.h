@@ -1,6 +1,8 @@
 #pragma once
 
 #include "ai_agent_base.h"
+#include "search_clock.h"
+#include "search_score.h"
 #include <chrono>
 
 // MinMax AI agent with alpha-beta pruning
@@ -14,21 +16,15 @@ public:
 
 private:
   int maxDepth;
-  double minMax(Board &board, int depth, double alpha, double beta,
-                CellState player, bool isMaximizing,
-                std::chrono::steady_clock::time_point startTime,
-                std::chrono::milliseconds timeLimit);
-  double evaluateBoard(const Board &board, CellState player) const;
+  SearchClock clock;
+  Score minMax(Board &board, int depth, Score alpha, Score beta,
+               CellState player, bool isMaximizing);
+  Score evaluateBoard(const Board &board, CellState player) const;
 
   // Private evaluation methods for MinMax strategy
-  double evaluateCornerControl(const Board &board, CellState player) const;
-  double evaluateEdgeControl(const Board &board, CellState player) const;
-  double evaluateMobility(const Board &board, CellState player) const;
-  double evaluateDiscCount(const Board &board, CellState player) const;
-  double evaluateStability(const Board &board, CellState player) const;
-
-protected:
-  bool isTimeUp(std::chrono::steady_clock::time_point startTime,
-                std::chrono::milliseconds timeLimit =
-                    std::chrono::milliseconds(1000)) const;
+  Score evaluateCornerControl(const Board &board, CellState player) const;
+  Score evaluateEdgeControl(const Board &board, CellState player) const;
+  Score evaluateMobility(const Board &board, CellState player) const;
+  Score evaluateDiscCount(const Board &board, CellState player) const;
+  Score evaluateStability(const Board &board, CellState player) const;
 };
@@ -2,9 +2,14 @@
 
 #include "ai_agent_base.h"
 #include "bitboard.h"
+#include "search_clock.h"
+#include "transposition_table.h"
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <limits>
+#include <memory>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -13,108 +18,118 @@ enum class CellState;
 
 class PandaAIAgent : public AIAgentBase {
 public:
+  // threads > 1 searches with Lazy SMP: threads - 1 helpers search the same
+  // position alongside the main search and share its transposition table
   PandaAIAgent(const std::string &name = "Panda",
-               const std::string &author = "PandaAI-Dev", int maxDepth = 12);
+               const std::string &author = "PandaAI-Dev", int maxDepth = 12,
+               int threads = 1);
+  ~PandaAIAgent() override;
 
   std::pair<int, int> getBestMove(const Board &board, CellState player,
                                   std::chrono::milliseconds timeLimit =
                                       std::chrono::milliseconds(1000)) override;
 
+  void onGameStart() override;
+  void onMoveMade(int row, int col, CellState player) override;
+  void stopPondering() override;
+
+  // For benchmarks: one negamax search of the position to a fixed depth,
+  // without the opening book, endgame solver or time limit
+  Score searchToDepth(const BitBoard &bitboard, bool isBlack, int depth);
+  // Nodes visited by the last search on the calling thread
+  uint64_t getLastSearchNodes() const { return clock.nodes(); }
+  // Search children on a copy of the board instead of making and unmaking
+  // moves on one; kept to benchmark the two against each other
+  void setCopyMake(bool enabled) { copyMake = enabled; }
+
 private:
   int maxDepth;
+  int threads;
+  bool copyMake = false;
   static constexpr int ENDGAME_DEPTH = 16;
-  static constexpr size_t TT_SIZE = 2097152;
+  static constexpr size_t TT_MEGABYTES = 32;
 
-  mutable uint64_t nodesSearched;
+  // Searches run against this clock, moves and pondering alike
+  SearchClock clock;
+
+  // Background search on the expected reply; see startPondering
+  static constexpr std::chrono::milliseconds PONDER_LIMIT{3600000};
+  std::thread ponderThread;
+  std::pair<int, int> ponderReply{-1, -1};
+  bool ponderIsBlack = false;
+  void startPondering(const BitBoard &bitboard, std::pair<int, int> move,
+                      bool isBlack);
 
   enum class GamePhase { OPENING, MIDGAME, ENDGAME };
   GamePhase getGamePhase(const BitBoard &bitboard) const;
 
-  std::pair<int, int>
-  iterativeDeepeningSearch(const BitBoard &bitboard, bool isBlack,
-                           std::chrono::steady_clock::time_point startTime,
-                           std::chrono::milliseconds timeLimit);
+  // Runs against the already started clock
+  std::pair<int, int> iterativeDeepeningSearch(BitBoard &bitboard,
+                                               bool isBlack);
+
+  // Lazy SMP helpers. Each runs its own iterative deepening, odd ones a
+  // depth ahead, until the main search stops its clock; only the entries
+  // they leave in the transposition table are used.
+  std::unique_ptr<SearchClock[]> helperClocks;
+  void helperSearch(BitBoard bitboard, bool isBlack, int firstDepth,
+                    SearchClock &helperClock);
 
-  double negamax(BitBoard &bitboard, int depth, double alpha, double beta,
-                 bool isBlack, std::chrono::steady_clock::time_point startTime,
-                 std::chrono::milliseconds timeLimit, bool &timeUp);
+  // searchClock is the calling thread's: clock, or a helper's
+  Score negamax(BitBoard &bitboard, int depth, Score alpha, Score beta,
+                bool isBlack, SearchClock &searchClock);
 
-  double exactEndgameSearch(BitBoard &bitboard, bool isBlack, int emptySquares,
-                            std::chrono::steady_clock::time_point startTime,
-                            std::chrono::milliseconds timeLimit, bool &timeUp);
+  Score exactEndgameSearch(BitBoard &bitboard, bool isBlack, int emptySquares);
 
   // Evaluation system
-  double evaluatePosition(const BitBoard &bitboard, bool isBlack) const;
-  double evaluateMobility(const BitBoard &bitboard, bool isBlack) const;
-  double evaluateCornerControl(const BitBoard &bitboard, bool isBlack) const;
-  double evaluateEdgeControl(const BitBoard &bitboard, bool isBlack) const;
-  double evaluateStability(const BitBoard &bitboard, bool isBlack) const;
-  double evaluateDiscCount(const BitBoard &bitboard, bool isBlack) const;
-  double evaluatePositional(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluatePosition(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluateMobility(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluateCornerControl(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluateEdgeControl(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluateStability(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluateDiscCount(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluatePositional(const BitBoard &bitboard, bool isBlack) const;
 
   struct EvaluationWeights {
-    double mobility;
-    double cornerControl;
-    double edgeControl;
-    double stability;
-    double discCount;
-    double positional;
+    int mobility;
+    int cornerControl;
+    int edgeControl;
+    int stability;
+    int discCount;
+    int positional;
   };
 
   EvaluationWeights getWeights(GamePhase phase) const;
 
-  // Transposition table
-  enum class EntryType { EXACT, LOWER_BOUND, UPPER_BOUND };
-  struct TTEntry {
-    uint64_t hash;
-    double score;
-    int depth;
-    EntryType type;
-    std::pair<int, int> bestMove;
-
-    TTEntry()
-        : hash(0), score(0.0), depth(0), type(EntryType::EXACT),
-          bestMove({-1, -1}) {}
-    TTEntry(uint64_t h, double s, int d, EntryType t, std::pair<int, int> move)
-        : hash(h), score(s), depth(d), type(t), bestMove(move) {}
-  };
-
-  mutable std::vector<TTEntry> transpositionTable;
+  // Transposition table, shared by all search threads
+  using EntryType = TTBound;
+  mutable TranspositionTable transpositionTable{TT_MEGABYTES};
 
   mutable std::array<int, 64> historyTable = {0};
 
-  bool probeTTEntry(uint64_t hash, int depth, double alpha, double beta,
-                    double &score, std::pair<int, int> &bestMove) const;
-  void storeTTEntry(uint64_t hash, double score, int depth, EntryType type,
+  bool probeTTEntry(uint64_t hash, int depth, Score alpha, Score beta,
+                    Score &score, std::pair<int, int> &bestMove) const;
+  void storeTTEntry(uint64_t hash, Score score, int depth, EntryType type,
                     std::pair<int, int> bestMove) const;
 
-  // Move ordering
-  std::vector<std::pair<int, int>>
-  orderMoves(const BitBoard &bitboard,
-             const std::vector<std::pair<int, int>> &moves, bool isBlack,
-             std::pair<int, int> ttMove = {-1, -1}) const;
+  // Move ordering; also prefetches the children's table entries
+  void orderMoves(const BitBoard &bitboard, MoveList &moves, bool isBlack,
+                  std::pair<int, int> ttMove = {-1, -1}) const;
 
-  double scoreMoveForOrdering(const BitBoard &bitboard,
-                              std::pair<int, int> move, bool isBlack) const;
+  int scoreMoveForOrdering(const BitBoard &bitboard,
+                           std::pair<int, int> move, bool isBlack) const;
 
   // Opening book
   std::pair<int, int> getOpeningMove(const BitBoard &bitboard,
                                      bool isBlack) const;
   bool isOpeningPosition(const BitBoard &bitboard) const;
 
-  std::pair<int, int>
-  selectStrategicOpeningMove(const BitBoard &bitboard,
-                             const std::vector<std::pair<int, int>> &validMoves,
-                             bool isBlack) const;
+  std::pair<int, int> selectStrategicOpeningMove(const BitBoard &bitboard,
+                                                 const MoveList &validMoves,
+                                                 bool isBlack) const;
 
   // Utility methods
   bool isCorner(int row, int col) const;
   bool isEdge(int row, int col) const;
-  bool isTimeUp(std::chrono::steady_clock::time_point startTime,
-                std::chrono::milliseconds timeLimit) const;
-
-  // Bitboard conversion
-  BitBoard boardToBitboard(const Board &board) const;
 
   // Position evaluation tables
   static const std::array<std::array<int, 8>, 8> POSITION_VALUES;
@@ -2,11 +2,12 @@
 
 #include "ai_agent_base.h"
 #include "bitboard.h"
+#include "search_clock.h"
+#include "transposition_table.h"
 #include <algorithm>
 #include <chrono>
 #include <limits>
 #include <random>
-#include <unordered_map>
 #include <vector>
 
 class Board;
@@ -21,54 +22,50 @@ public:
                                   std::chrono::milliseconds timeLimit =
                                       std::chrono::milliseconds(1000)) override;
 
+  // Keeps the transposition table from earlier games; see
+  // TranspositionTable::newGame
+  void onGameStart() override;
+
 private:
   int maxDepth;
+  SearchClock clock;
 
-  double bitboardMinMax(BitBoard &bitboard, int depth, double alpha,
-                        double beta, bool isBlack, bool isMaximizing,
-                        std::chrono::steady_clock::time_point startTime,
-                        std::chrono::milliseconds timeLimit);
+  Score bitboardMinMax(BitBoard &bitboard, int depth, Score alpha,
+                       Score beta, bool isBlack, bool isMaximizing);
 
-  double evaluateBitboard(const BitBoard &bitboard, bool isBlack) const;
-  double evaluateCornerControlBitboard(const BitBoard &bitboard,
-                                       bool isBlack) const;
-  double evaluateEdgeControlBitboard(const BitBoard &bitboard,
-                                     bool isBlack) const;
-  double evaluateMobilityBitboard(const BitBoard &bitboard, bool isBlack) const;
-  double evaluateStabilityBitboard(const BitBoard &bitboard,
-                                   bool isBlack) const;
-  double evaluateDiscCountBitboard(const BitBoard &bitboard,
-                                   bool isBlack) const;
+  Score evaluateBitboard(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluateCornerControlBitboard(const BitBoard &bitboard,
+                                      bool isBlack) const;
+  Score evaluateEdgeControlBitboard(const BitBoard &bitboard,
+                                    bool isBlack) const;
+  Score evaluateMobilityBitboard(const BitBoard &bitboard, bool isBlack) const;
+  Score evaluateStabilityBitboard(const BitBoard &bitboard,
+                                  bool isBlack) const;
+  Score evaluateDiscCountBitboard(const BitBoard &bitboard,
+                                  bool isBlack) const;
 
   static const std::array<std::array<int, 8>, 8> POSITION_VALUES;
   static const std::array<std::array<int, 8>, 8> EARLY_GAME_VALUES;
   static const std::array<std::array<int, 8>, 8> LATE_GAME_VALUES;
 
-  enum class EntryType { EXACT, LOWER_BOUND, UPPER_BOUND };
-  struct TranspositionEntry {
-    uint64_t hash;
-    double score;
-    int depth;
-    EntryType type;
-    std::chrono::steady_clock::time_point timestamp;
-    TranspositionEntry()
-        : hash(0), score(0.0), depth(0), type(EntryType::EXACT) {}
-    TranspositionEntry(uint64_t h, double s, int d, EntryType t)
-        : hash(h), score(s), depth(d), type(t) {}
-  };
-  mutable std::unordered_map<uint64_t, TranspositionEntry> transpositionTable;
-  static constexpr size_t MAX_TRANSPOSITION_SIZE = 1000000;
+  using EntryType = TTBound;
+  static constexpr size_t TT_MEGABYTES = 16;
+  mutable TranspositionTable transpositionTable{TT_MEGABYTES};
+  // Keys include the side to move, as a pass searches the same board for
+  // the other side. Scores are from the root player's side, so each colour
+  // has its own entries too.
+  static constexpr uint64_t BLACK_ROOT_KEY = 0xC2B2AE3D27D4EB4FULL;
+  // Stores unless the clock has cut the search short
+  void ttStore(uint64_t hash, Score score, int depth, EntryType type);
 
-  uint64_t getZobristHash(const BitBoard &bitboard) const;
-  void clearTranspositionTable();
+  uint64_t getZobristHash(const BitBoard &bitboard, bool blackToMove) const;
   size_t getTranspositionTableSize() const;
 
   bool isBlackPlayer(CellState player) const;
   CellState playerFromBool(bool isBlack) const;
 
-  std::vector<std::pair<int, int>>
-  orderMoves(const BitBoard &bitboard,
-             const std::vector<std::pair<int, int>> &moves, bool isBlack) const;
+  void orderMoves(const BitBoard &bitboard, MoveList &moves,
+                  bool isBlack) const;
 
   // Quiescence search placeholder (not implemented yet)
   // double quiescenceSearch(BitBoard& bitboard, double alpha, double beta,
@@ -5,8 +5,6 @@
 #include <limits>
 #include <random>
 
-bool phase2 = false;
-
 AgentDuJardin::AgentDuJardin(const std::string &name, const std::string &author,
                              int depth)
     : AIAgentBase(name, author), maxDepth(depth) {}
@@ -14,26 +12,18 @@ AgentDuJardin::AgentDuJardin(const std::string &name, const std::string &author,
 inline std::pair<int, int>
 AgentDuJardin::getBestMove(const Board &board, CellState player,
                            std::chrono::milliseconds timeLimit) {
-  auto startTime = std::chrono::steady_clock::now();
-  transpositionTable.clear();
-  BitBoard bitboard;
-  for (int row = 0; row < 8; ++row) {
-    for (int col = 0; col < 8; ++col) {
-      CellState cell = board.getCell(row, col);
-      if (cell == CellState::BLACK) {
-        bitboard.setCell(row, col, 1);
-      } else if (cell == CellState::WHITE) {
-        bitboard.setCell(row, col, 2);
-      }
-    }
-  }
+  // Keep 5% of the time as a safety margin
+  clock.start(timeLimit * 95 / 100);
+  transpositionTable.newSearch();
+  BitBoard bitboard = getBitBoard(board);
   bool isBlackTurn = (player == CellState::BLACK);
-  auto moves = bitboard.getValidMoves(isBlackTurn);
+  MoveList moves;
+  bitboard.getValidMoves(isBlackTurn, moves);
   if (moves.empty())
     return {-1, -1};
-  moves = orderMoves(bitboard, moves, isBlackTurn);
-  std::pair<int, int> bestMove = moves.front();
-  double bestScore = std::numeric_limits<double>::lowest();
+  orderMoves(bitboard, moves, isBlackTurn);
+  std::pair<int, int> bestMove = moves[0];
+  Score bestScore = -SCORE_INFINITY;
 
   int depth = computeDepth(bitboard, isBlackTurn);
 
@@ -42,15 +32,15 @@ AgentDuJardin::getBestMove(const Board &board, CellState player,
   // phase2 = bitboard.getTotalDiscs() > 20;
   phase2 = bitboard.getTotalDiscs() > 4;
 
-  for (const auto &mv : moves) {
-    if (isTimeUpLarge(startTime, timeLimit))
+  for (int i = 0; i < moves.size(); ++i) {
+    const auto mv = moves[i];
+    if (clock.hardTimeUp())
       break;
-    BitBoard temp = bitboard;
-    if (temp.makeMove(mv.first, mv.second, isBlackTurn)) {
-      double score =
-          bitboardMinMax(temp, depth, std::numeric_limits<double>::lowest(),
-                         std::numeric_limits<double>::max(), isBlackTurn, false,
-                         startTime, timeLimit);
+    BitBoard::Undo undo;
+    if (bitboard.makeMove(moves.square(i), isBlackTurn, undo)) {
+      Score score = bitboardMinMax(bitboard, depth, -SCORE_INFINITY,
+                                   SCORE_INFINITY, isBlackTurn, false);
+      bitboard.unmakeMove(undo);
       if (score > bestScore) {
         bestScore = score;
         bestMove = mv;
@@ -61,6 +51,8 @@ AgentDuJardin::getBestMove(const Board &board, CellState player,
   return bestMove;
 }
 
+void AgentDuJardin::onGameStart() { transpositionTable.newGame(); }
+
 int AgentDuJardin::computeDepth(const BitBoard &bitboard, bool isBlack) const {
   (void)isBlack; // Suppress unused parameter warning
   if (bitboard.getTotalDiscs() < 20) {
@@ -69,201 +61,186 @@ int AgentDuJardin::computeDepth(const BitBoard &bitboard, bool isBlack) const {
   return maxDepth - 1;
 }
 
-inline double
-AgentDuJardin::bitboardMinMax(BitBoard &bitboard, int depth, double alpha,
-                              double beta, bool isBlack, bool isMaximizing,
-                              std::chrono::steady_clock::time_point startTime,
-                              std::chrono::milliseconds timeLimit) {
-  if (isTimeUpLarge(startTime, timeLimit))
-    return 0.0;
-  uint64_t hash = getZobristHash(bitboard);
-  auto it = transpositionTable.find(hash);
-  if (it != transpositionTable.end()) {
-    const TranspositionEntry &entry = it->second[isMaximizing ? 1 : 0];
-    if (entry.depth >= depth && entry.isMaximizing == isMaximizing &&
-        entry.depth != -1) {
-      switch (entry.type) {
-      case EntryType::EXACT:
+inline Score
+AgentDuJardin::bitboardMinMax(BitBoard &bitboard, int depth, Score alpha,
+                              Score beta, bool isBlack, bool isMaximizing) {
+  if (clock.timeUp())
+    return 0;
+  const Score alphaOrig = alpha;
+  const Score betaOrig = beta;
+  uint64_t hash = getZobristHash(bitboard) ^
+                  (isMaximizing ? MAXIMIZING_KEY : 0) ^
+                  (isBlack ? BLACK_ROOT_KEY : 0);
+  TranspositionTable::Entry entry;
+  if (transpositionTable.probe(hash, entry) && entry.depth >= depth) {
+    switch (entry.bound) {
+    case EntryType::EXACT:
+      return entry.score;
+    case EntryType::LOWER_BOUND:
+      if (entry.score >= beta) {
+        return entry.score;
+      }
+      break;
+    case EntryType::UPPER_BOUND:
+      if (entry.score <= alpha) {
         return entry.score;
-      case EntryType::LOWER_BOUND:
-        if (entry.score >= beta) {
-          return entry.score;
-        }
-        break;
-      case EntryType::UPPER_BOUND:
-        if (entry.score <= alpha) {
-          return entry.score;
-        }
-        break;
       }
+      break;
     }
   }
   if (depth == 0) {
-    double sc = evaluateBitboard(bitboard, isBlack);
-    if (transpositionTable.size() < MAX_TRANSPOSITION_SIZE && phase2) {
-      transpositionTable[hash][isMaximizing ? 1 : 0] =
-          TranspositionEntry(hash, sc, depth, EntryType::EXACT, isMaximizing);
-    }
+    Score sc = evaluateBitboard(bitboard, isBlack);
+    ttStore(hash, sc, depth, EntryType::EXACT);
     return sc;
   }
   if (bitboard.isGameOver()) {
-    double sc = bitboard.getScore(isBlack) > bitboard.getScore(!isBlack)
-                    ? std::numeric_limits<double>::max()
-                    : std::numeric_limits<double>::lowest();
-    if (transpositionTable.size() < MAX_TRANSPOSITION_SIZE && phase2) {
-      transpositionTable[hash][isMaximizing ? 1 : 0] =
-          TranspositionEntry(hash, sc, depth, EntryType::EXACT, isMaximizing);
-    }
+    Score sc =
+        finalScore(bitboard.getScore(isBlack), bitboard.getScore(!isBlack));
+    ttStore(hash, sc, depth, EntryType::EXACT);
     return sc;
   }
-  auto moves = bitboard.getValidMoves(isMaximizing ? isBlack : !isBlack);
+  MoveList moves;
+  bitboard.getValidMoves(isMaximizing ? isBlack : !isBlack, moves);
   if (moves.empty()) {
-    double sc = bitboardMinMax(bitboard, depth - 1, alpha, beta, isBlack,
-                               !isMaximizing, startTime, timeLimit);
+    Score sc = bitboardMinMax(bitboard, depth - 1, alpha, beta, isBlack,
+                              !isMaximizing);
     return sc;
   }
-  moves = orderMoves(bitboard, moves, isMaximizing ? isBlack : !isBlack);
+  orderMoves(bitboard, moves, isMaximizing ? isBlack : !isBlack);
+  Score best = isMaximizing ? -SCORE_INFINITY : SCORE_INFINITY;
+  bool cutoff = false;
   if (isMaximizing) {
-    double best = std::numeric_limits<double>::lowest();
-    EntryType eType = EntryType::UPPER_BOUND;
-    for (const auto &mv : moves) {
-      if (isTimeUpLarge(startTime, timeLimit))
+    for (int i = 0; i < moves.size(); ++i) {
+      if (clock.timeUp())
         return best;
-      BitBoard temp = bitboard;
-      if (temp.makeMove(mv.first, mv.second, isBlack)) {
-        double sc = bitboardMinMax(temp, depth - 1, alpha, beta, isBlack, false,
-                                   startTime, timeLimit);
+      BitBoard::Undo undo;
+      if (bitboard.makeMove(moves.square(i), isBlack, undo)) {
+        Score sc =
+            bitboardMinMax(bitboard, depth - 1, alpha, beta, isBlack, false);
+        bitboard.unmakeMove(undo);
         best = std::max(best, sc);
         alpha = std::max(alpha, sc);
         if (beta <= alpha) {
-          if (transpositionTable.size() < MAX_TRANSPOSITION_SIZE && phase2) {
-            transpositionTable[hash][isMaximizing ? 1 : 0] = TranspositionEntry(
-                hash, best, depth, EntryType::UPPER_BOUND, isMaximizing);
-          }
+          cutoff = true;
           break;
         }
       }
     }
-    if (best <= alpha)
-      eType = EntryType::UPPER_BOUND;
-    else if (best >= beta)
-      eType = EntryType::LOWER_BOUND;
-    else
-      eType = EntryType::EXACT;
-    if (transpositionTable.size() < MAX_TRANSPOSITION_SIZE && phase2) {
-      transpositionTable[hash][isMaximizing ? 1 : 0] =
-          TranspositionEntry(hash, best, depth, eType, isMaximizing);
-    }
-    return best;
   } else {
-    double best = std::numeric_limits<double>::max();
-    EntryType eType = EntryType::LOWER_BOUND;
-    for (const auto &mv : moves) {
-      if (isTimeUpLarge(startTime, timeLimit))
+    for (int i = 0; i < moves.size(); ++i) {
+      if (clock.timeUp())
         return best;
-      BitBoard temp = bitboard;
-      if (temp.makeMove(mv.first, mv.second, !isBlack)) {
-        double sc = bitboardMinMax(temp, depth - 1, alpha, beta, isBlack, true,
-                                   startTime, timeLimit);
+      BitBoard::Undo undo;
+      if (bitboard.makeMove(moves.square(i), !isBlack, undo)) {
+        Score sc =
+            bitboardMinMax(bitboard, depth - 1, alpha, beta, isBlack, true);
+        bitboard.unmakeMove(undo);
         best = std::min(best, sc);
         beta = std::min(beta, sc);
         if (beta <= alpha) {
-          if (transpositionTable.size() < MAX_TRANSPOSITION_SIZE && phase2) {
-            transpositionTable[hash][isMaximizing ? 1 : 0] = TranspositionEntry(
-                hash, best, depth, EntryType::LOWER_BOUND, isMaximizing);
-          }
+          cutoff = true;
           break;
         }
       }
     }
-    if (best <= alpha)
-      eType = EntryType::UPPER_BOUND;
-    else if (best >= beta)
-      eType = EntryType::LOWER_BOUND;
-    else
-      eType = EntryType::EXACT;
-    if (transpositionTable.size() < MAX_TRANSPOSITION_SIZE && phase2) {
-      transpositionTable[hash][isMaximizing ? 1 : 0] =
-          TranspositionEntry(hash, best, depth, eType, isMaximizing);
-    }
-    return best;
   }
+  // A child cut short by the clock returns a guess, which must not reach
+  // the table that later moves read
+  if (clock.stopped())
+    return best;
+
+  // Classified against the window this node was called with, not the one
+  // its children narrowed
+  EntryType eType;
+  if (cutoff)
+    eType = isMaximizing ? EntryType::LOWER_BOUND : EntryType::UPPER_BOUND;
+  else if (best <= alphaOrig)
+    eType = EntryType::UPPER_BOUND;
+  else if (best >= betaOrig)
+    eType = EntryType::LOWER_BOUND;
+  else
+    eType = EntryType::EXACT;
+  ttStore(hash, best, depth, eType);
+  return best;
 }
 
-inline double AgentDuJardin::evaluateBitboard(const BitBoard &bitboard,
-                                              bool isBlack) const {
-  double sc = 0.0;
-  sc += evaluateCornerControlBitboard(bitboard, isBlack) * 25.0;
-  sc += evaluateEdgeControlBitboard(bitboard, isBlack) * 5.0;
-  sc += evaluateMobilityBitboard(bitboard, isBlack) * 15.0;
-  sc += evaluateDiscCountBitboard(bitboard, isBlack) * 5.0;
-  sc += evaluateStabilityBitboard(bitboard, isBlack) * 10.0;
+inline Score AgentDuJardin::evaluateBitboard(const BitBoard &bitboard,
+                                             bool isBlack) const {
+  Score sc = 0;
+  sc += evaluateCornerControlBitboard(bitboard, isBlack) * 25;
+  sc += evaluateEdgeControlBitboard(bitboard, isBlack) * 5;
+  sc += evaluateMobilityBitboard(bitboard, isBlack) * 15;
+  sc += evaluateDiscCountBitboard(bitboard, isBlack) * 5;
+  sc += evaluateStabilityBitboard(bitboard, isBlack) * 10;
   return sc;
 }
 
-inline double AgentDuJardin::evaluateStabilityBitboard(const BitBoard &bb,
-                                                       bool isBlack) const {
+inline Score AgentDuJardin::evaluateStabilityBitboard(const BitBoard &bb,
+                                                      bool isBlack) const {
   uint64_t pstable = bb.getStableMaskForPlayerBitwise(isBlack);
   int nb_pstable = __builtin_popcountll(pstable);
   uint64_t ostable = bb.getStableMaskForPlayerBitwise(!isBlack);
   int nb_ostable = __builtin_popcountll(ostable);
   if (nb_ostable + nb_pstable == 0) {
-    return 0.0;
+    return 0;
   }
-  double sc =
-      static_cast<double>(nb_pstable - nb_ostable) / (nb_pstable + nb_ostable);
+  Score sc =
+      (nb_pstable - nb_ostable) * SCORE_SCALE / (nb_pstable + nb_ostable);
   return sc;
 }
 
-inline double AgentDuJardin::evaluateCornerControlBitboard(const BitBoard &bb,
-                                                           bool isBlack) const {
+inline Score AgentDuJardin::evaluateCornerControlBitboard(const BitBoard &bb,
+                                                          bool isBlack) const {
   uint64_t corners = bb.getCornerMask();
   uint64_t player = bb.getPlayerBoard(isBlack);
   uint64_t opponent = bb.getOpponentBoard(isBlack);
   int pc = __builtin_popcountll(player & corners);
   int oc = __builtin_popcountll(opponent & corners);
-  return static_cast<double>(pc - oc);
+  return (pc - oc) * SCORE_SCALE;
 }
 
-inline double AgentDuJardin::evaluateEdgeControlBitboard(const BitBoard &bb,
-                                                         bool isBlack) const {
+inline Score AgentDuJardin::evaluateEdgeControlBitboard(const BitBoard &bb,
+                                                        bool isBlack) const {
   uint64_t edges = bb.getEdgeMask();
   uint64_t player = bb.getPlayerBoard(isBlack);
   uint64_t opponent = bb.getOpponentBoard(isBlack);
   int pe = __builtin_popcountll(player & edges);
   int oe = __builtin_popcountll(opponent & edges);
-  return static_cast<double>(pe - oe);
+  return (pe - oe) * SCORE_SCALE;
 }
 
-inline double AgentDuJardin::evaluateMobilityBitboard(const BitBoard &bb,
-                                                      bool isBlack) const {
-  int pMoves = bb.getValidMoves(isBlack).size();
-  int oMoves = bb.getValidMoves(!isBlack).size();
+inline Score AgentDuJardin::evaluateMobilityBitboard(const BitBoard &bb,
+                                                     bool isBlack) const {
+  int pMoves = __builtin_popcountll(bb.legalMovesMask(isBlack));
+  int oMoves = __builtin_popcountll(bb.legalMovesMask(!isBlack));
   if (pMoves + oMoves == 0)
-    return 0.0;
-  return static_cast<double>(pMoves - oMoves) / (pMoves + oMoves);
+    return 0;
+  return (pMoves - oMoves) * SCORE_SCALE / (pMoves + oMoves);
 }
 
-inline double AgentDuJardin::evaluateDiscCountBitboard(const BitBoard &bb,
-                                                       bool isBlack) const {
+inline Score AgentDuJardin::evaluateDiscCountBitboard(const BitBoard &bb,
+                                                      bool isBlack) const {
   int p = bb.getScore(isBlack);
   int o = bb.getScore(!isBlack);
   int t = bb.getTotalDiscs();
   if (t == 0)
-    return 0.0;
-  return static_cast<double>(p - o) / t;
+    return 0;
+  return (p - o) * SCORE_SCALE / t;
 }
 
 inline uint64_t AgentDuJardin::getZobristHash(const BitBoard &bb) const {
   return bb.getCanonicalZobristHash();
 }
 
-inline void AgentDuJardin::clearTranspositionTable() {
-  transpositionTable.clear();
+void AgentDuJardin::ttStore(uint64_t hash, Score score, int depth,
+                            EntryType type) {
+  if (phase2 && !clock.stopped()) {
+    transpositionTable.store(hash, score, depth, type);
+  }
 }
 
 inline size_t AgentDuJardin::getTranspositionTableSize() const {
-  return transpositionTable.size();
+  return transpositionTable.entries();
 }
 
 inline bool AgentDuJardin::isBlackPlayer(CellState p) const {
@@ -274,79 +251,54 @@ inline CellState AgentDuJardin::playerFromBool(bool isBlack) const {
   return isBlack ? CellState::BLACK : CellState::WHITE;
 }
 
-inline std::vector<std::pair<int, int>>
-AgentDuJardin::orderMoves(const BitBoard &bb,
-                          const std::vector<std::pair<int, int>> &moves,
-                          bool isBlack) const {
-  std::vector<std::pair<std::pair<int, int>, double>> moveScores;
-
+inline void AgentDuJardin::orderMoves(const BitBoard &bb, MoveList &moves,
+                                      bool isBlack) const {
   uint64_t playerCorners = bb.getPlayerCorners(isBlack);
+  uint64_t player = bb.getPlayerBoard(isBlack);
+  uint64_t opponent = bb.getOpponentBoard(isBlack);
 
   auto isCornerControlled = [&](int r, int c) {
     return (playerCorners & (1ULL << (r * 8 + c))) != 0;
   };
 
-  for (const auto &mv : moves) {
-    double score = 0.0;
+  for (int i = 0; i < moves.size(); ++i) {
+    const auto mv = moves[i];
+    int score = 0;
 
     // Corner
     if ((mv.first == 0 || mv.first == 7) &&
         (mv.second == 0 || mv.second == 7)) {
-      score += 1000.0;
+      score += 1000;
     } else if (isXSquare(mv.first, mv.second)) {
       int corner_r = (mv.first < 4) ? 0 : 7;
       int corner_c = (mv.second < 4) ? 0 : 7;
       if (!isCornerControlled(corner_r, corner_c)) {
-        score -= 500.0;
+        score -= 500;
       }
     } else if (isCSquare(mv.first, mv.second)) {
       int corner_r = (mv.first < 4) ? 0 : 7;
       int corner_c = (mv.second < 4) ? 0 : 7;
       if (!isCornerControlled(corner_r, corner_c)) {
-        score -= 250.0;
+        score -= 250;
       }
     }
     // Bords autres que coins
     else if (mv.first == 0 || mv.first == 7 || mv.second == 0 ||
              mv.second == 7) {
-      score += 100.0;
+      score += 100;
     }
-    BitBoard tmp = bb;
-    int before = bb.getScore(isBlack);
-    if (tmp.makeMove(mv.first, mv.second, isBlack)) {
-      int after = tmp.getScore(isBlack);
-      int flips = after - before - 1;
-      if (flips > 0)
-        score += flips * 10.0;
+    uint64_t flips = BitBoard::flipsMask(moves.square(i), player, opponent);
+    score += __builtin_popcountll(flips) * 10;
 
-      if (tmp.getValidMoves(!isBlack).empty())
-        score += 1000;
-    }
+    // Moves that leave the opponent without a reply
+    uint64_t after = player | flips | (1ULL << moves.square(i));
+    if (!BitBoard::legalMovesMask(opponent ^ flips, after))
+      score += 1000;
 
-    moveScores.emplace_back(mv, score);
+    moves.setScore(i, score);
   }
 
-  std::sort(moveScores.begin(), moveScores.end(),
-            [](const auto &a, const auto &b) { return a.second > b.second; });
-
-  std::vector<std::pair<int, int>> ordered;
-  ordered.reserve(moveScores.size());
-  for (const auto &ms : moveScores)
-    ordered.push_back(ms.first);
-
-  return ordered;
-}
-
-inline bool
-AgentDuJardin::isTimeUpLarge(std::chrono::steady_clock::time_point startTime,
-                             std::chrono::milliseconds timeLimit) const {
-  auto now = std::chrono::steady_clock::now();
-  auto elapsed =
-      std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime);
-
-  auto threshold = std::chrono::milliseconds(
-      static_cast<long long>(timeLimit.count() * 0.95));
-  return elapsed >= threshold;
+  moves.sortByScore();
 }
 
 REGISTER_AI_AGENT(AgentDuJardin, "agentDuJardin")
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <limits>
 #include <random>
+#include <thread>
 
 const std::array<std::array<int, 8>, 8> BitBoardAIAgent::POSITION_VALUES = {
     {{{100, -20, 10, 5, 5, 10, -20, 100}},
@@ -28,59 +29,57 @@ const std::array<std::array<int, 8>, 8> BitBoardAIAgent::LATE_GAME_VALUES = {
      {{100, 50, 30, 20, 20, 30, 50, 100}}}};
 
 BitBoardAIAgent::BitBoardAIAgent(const std::string &name,
-                                 const std::string &author, int depth)
+                                 const std::string &author, int depth,
+                                 int threads)
     : AIAgentBase(name, author), maxDepth(depth),
-      transpositionTable(TT_NUM_BUCKETS) {}
+      threads(std::max(1, threads)),
+      workerClocks(new SearchClock[this->threads - 1]) {
+  if (this->threads > 1) {
+    pool = std::make_unique<TaskPool>(this->threads);
+  }
+}
 
 inline std::pair<int, int>
 BitBoardAIAgent::getBestMove(const Board &board, CellState player,
                              std::chrono::milliseconds timeLimit) {
-  auto startTime = std::chrono::steady_clock::now();
-  clearTranspositionTable();
-  BitBoard bitboard;
-  for (int row = 0; row < 8; ++row) {
-    for (int col = 0; col < 8; ++col) {
-      CellState cell = board.getCell(row, col);
-      if (cell == CellState::BLACK) {
-        bitboard.setCell(row, col, 1);
-      } else if (cell == CellState::WHITE) {
-        bitboard.setCell(row, col, 2);
-      }
-    }
+  // Stop a few milliseconds early to leave room for returning the move
+  clock.start(timeLimit - std::chrono::milliseconds{3});
+  for (int i = 1; i < threads; ++i) {
+    workerClocks[i - 1].start(timeLimit - std::chrono::milliseconds{3});
   }
+  transpositionTable.newSearch();
+  BitBoard bitboard = getBitBoard(board);
   bool isBlackTurn = (player == CellState::BLACK);
-  auto moves = bitboard.getValidMoves(isBlackTurn);
+  MoveList moves;
+  bitboard.getValidMoves(isBlackTurn, moves);
   if (moves.empty())
     return {-1, -1};
-  moves = orderMoves(bitboard, moves, isBlackTurn);
+  orderMoves(bitboard, moves, isBlackTurn, isBlackTurn);
 
-  std::pair<int, int> bestMove = moves.front();
-  double bestScore = std::numeric_limits<double>::lowest();
+  std::pair<int, int> bestMove = moves[0];
+  Score bestScore = -SCORE_INFINITY;
   std::pair<int, int> lastCompletedBestMove = bestMove;
 
   for (int depth = 1; depth <= maxDepth; ++depth) {
-    if (isTimeUp(startTime, timeLimit))
+    if (!clock.nextIterationFits())
       break;
 
-    if (!moves.empty() && !(moves.front() == lastCompletedBestMove)) {
-      auto it = std::find(moves.begin(), moves.end(), lastCompletedBestMove);
-      if (it != moves.end()) {
-        std::iter_swap(moves.begin(), it);
-      }
-    }
+    moves.moveToFront(lastCompletedBestMove.first * 8 +
+                      lastCompletedBestMove.second);
 
-    std::pair<int, int> iterationBestMove = moves.front();
-    double iterationBestScore = std::numeric_limits<double>::lowest();
+    std::pair<int, int> iterationBestMove = moves[0];
+    Score iterationBestScore = -SCORE_INFINITY;
 
-    for (const auto &mv : moves) {
-      if (isTimeUp(startTime, timeLimit))
+    for (int i = 0; i < moves.size(); ++i) {
+      const auto mv = moves[i];
+      if (clock.hardTimeUp())
         break;
-      BitBoard temp = bitboard;
-      if (temp.makeMove(mv.first, mv.second, isBlackTurn)) {
-        double score = bitboardMinMax(temp, depth - 1,
-                                      std::numeric_limits<double>::lowest(),
-                                      std::numeric_limits<double>::max(),
-                                      isBlackTurn, false, startTime, timeLimit);
+      BitBoard::Undo undo;
+      if (bitboard.makeMove(moves.square(i), isBlackTurn, undo)) {
+        Score score =
+            bitboardMinMax(bitboard, depth - 1, -SCORE_INFINITY,
+                           SCORE_INFINITY, isBlackTurn, false, clock, nullptr);
+        bitboard.unmakeMove(undo);
         if (score > iterationBestScore) {
           iterationBestScore = score;
           iterationBestMove = mv;
@@ -88,10 +87,12 @@ BitBoardAIAgent::getBestMove(const Board &board, CellState player,
       }
     }
 
-    if (iterationBestScore != std::numeric_limits<double>::lowest()) {
+    if (iterationBestScore != -SCORE_INFINITY) {
       bestMove = iterationBestMove;
       bestScore = iterationBestScore;
       lastCompletedBestMove = iterationBestMove;
+      if (!clock.stopped())
+        clock.iterationDone();
     } else {
       break;
     }
@@ -101,128 +102,199 @@ BitBoardAIAgent::getBestMove(const Board &board, CellState player,
   return bestMove;
 }
 
-inline double
-BitBoardAIAgent::bitboardMinMax(BitBoard &bitboard, int depth, double alpha,
-                                double beta, bool isBlack, bool isMaximizing,
-                                std::chrono::steady_clock::time_point startTime,
-                                std::chrono::milliseconds timeLimit) {
-  if (isTimeUp(startTime, timeLimit))
+void BitBoardAIAgent::onGameStart() { transpositionTable.newGame(threads); }
+
+uint64_t BitBoardAIAgent::getLastSearchNodes() const {
+  uint64_t nodes = clock.nodes();
+  for (int i = 1; i < threads; ++i) {
+    nodes += workerClocks[i - 1].nodes();
+  }
+  return nodes;
+}
+
+bool BitBoardAIAgent::isCancelled(const SplitPoint *splitPoint) {
+  for (; splitPoint != nullptr; splitPoint = splitPoint->parent) {
+    if (splitPoint->cancelled.load(std::memory_order_relaxed))
+      return true;
+  }
+  return false;
+}
+
+SearchClock &BitBoardAIAgent::clockFor(int thread) {
+  return thread == 0 ? clock : workerClocks[thread - 1];
+}
+
+inline Score BitBoardAIAgent::bitboardMinMax(BitBoard &bitboard, int depth,
+                                             Score alpha, Score beta,
+                                             bool isBlack, bool isMaximizing,
+                                             SearchClock &searchClock,
+                                             const SplitPoint *parent) {
+  if (searchClock.timeUp() || isCancelled(parent))
     return evaluateBitboard(bitboard, isBlack);
-  const double alphaOrig = alpha;
-  const double betaOrig = beta;
-  bool wroteTT = false;
-  bool interrupted = false;
-  uint64_t hash = getZobristHash(bitboard, isMaximizing ? isBlack : !isBlack);
-  if (const TranspositionEntry *hit = ttLookup(hash, depth)) {
-    switch (hit->type) {
+  const Score alphaOrig = alpha;
+  const Score betaOrig = beta;
+  uint64_t hash = getZobristHash(bitboard, isMaximizing ? isBlack : !isBlack) ^
+                  (isBlack ? BLACK_ROOT_KEY : 0);
+  TTEntry hit;
+  if (ttLookup(hash, depth, hit)) {
+    switch (hit.bound) {
     case EntryType::EXACT:
-      return hit->score;
+      return hit.score;
     case EntryType::LOWER_BOUND:
-      if (hit->score >= beta)
-        return hit->score;
+      if (hit.score >= beta)
+        return hit.score;
       break;
     case EntryType::UPPER_BOUND:
-      if (hit->score <= alpha)
-        return hit->score;
+      if (hit.score <= alpha)
+        return hit.score;
       break;
     }
   }
-  if (depth == 0 || bitboard.isGameOver()) {
-    double sc = evaluateBitboard(bitboard, isBlack);
+  if (bitboard.isGameOver()) {
+    Score sc =
+        finalScore(bitboard.getScore(isBlack), bitboard.getScore(!isBlack));
+    ttStore(hash, sc, depth, EntryType::EXACT);
+    return sc;
+  }
+  if (depth == 0) {
+    Score sc = evaluateBitboard(bitboard, isBlack);
     ttStore(hash, sc, depth, EntryType::EXACT);
     return sc;
   }
   bool sideToMoveBlack = (isMaximizing ? isBlack : !isBlack);
-  auto moves = bitboard.getValidMoves(sideToMoveBlack);
+  MoveList moves;
+  bitboard.getValidMoves(sideToMoveBlack, moves);
   if (moves.empty()) {
-    double sc = bitboardMinMax(bitboard, depth, alpha, beta, isBlack,
-                               !isMaximizing, startTime, timeLimit);
+    Score sc = bitboardMinMax(bitboard, depth, alpha, beta, isBlack,
+                              !isMaximizing, searchClock, parent);
     return sc;
   }
-  moves = orderMoves(bitboard, moves, isMaximizing ? isBlack : !isBlack);
-  if (isMaximizing) {
-    double best = std::numeric_limits<double>::lowest();
-    EntryType eType = EntryType::UPPER_BOUND;
-    for (const auto &mv : moves) {
-      if (isTimeUp(startTime, timeLimit)) {
-        interrupted = true;
-        break;
-      }
-      BitBoard temp = bitboard;
-      if (temp.makeMove(mv.first, mv.second, isBlack)) {
-        double sc = bitboardMinMax(temp, depth - 1, alpha, beta, isBlack, false,
-                                   startTime, timeLimit);
-        best = std::max(best, sc);
-        alpha = std::max(alpha, sc);
-        if (beta <= alpha) {
-          ttStore(hash, best, depth, EntryType::LOWER_BOUND);
-          wroteTT = true;
-          break;
-        }
-      }
-    }
-    if (interrupted) {
-      if (best == std::numeric_limits<double>::lowest())
-        return evaluateBitboard(bitboard, isBlack);
-      return best;
+  orderMoves(bitboard, moves, sideToMoveBlack, isBlack);
+
+  const Score worst = isMaximizing ? -SCORE_INFINITY : SCORE_INFINITY;
+  Score best = worst;
+  bool cutoff = false;
+  bool interrupted = false;
+  for (int i = 0; i < moves.size(); ++i) {
+    if (searchClock.timeUp() || isCancelled(parent)) {
+      interrupted = true;
+      break;
     }
-    if (!interrupted && !wroteTT) {
-      if (best <= alphaOrig)
-        eType = EntryType::UPPER_BOUND;
-      else if (best >= betaOrig)
-        eType = EntryType::LOWER_BOUND;
-      else
-        eType = EntryType::EXACT;
-      ttStore(hash, best, depth, eType);
+    // Young Brothers Wait: the eldest child is searched first, alone
+    if (i == 1 && pool && depth >= MIN_SPLIT_DEPTH) {
+      interrupted =
+          searchYoungerBrothers(bitboard, moves, depth, alpha, beta, isBlack,
+                                isMaximizing, best, cutoff, parent);
+      break;
     }
-    return best;
-  } else {
-    double best = std::numeric_limits<double>::max();
-    EntryType eType = EntryType::LOWER_BOUND;
-    for (const auto &mv : moves) {
-      if (isTimeUp(startTime, timeLimit)) {
-        interrupted = true;
-        break;
-      }
-      BitBoard temp = bitboard;
-      if (temp.makeMove(mv.first, mv.second, !isBlack)) {
-        double sc = bitboardMinMax(temp, depth - 1, alpha, beta, isBlack, true,
-                                   startTime, timeLimit);
+    BitBoard::Undo undo;
+    if (bitboard.makeMove(moves.square(i), sideToMoveBlack, undo)) {
+      Score sc = bitboardMinMax(bitboard, depth - 1, alpha, beta, isBlack,
+                                !isMaximizing, searchClock, parent);
+      bitboard.unmakeMove(undo);
+      if (isMaximizing) {
+        best = std::max(best, sc);
+        alpha = std::max(alpha, sc);
+      } else {
         best = std::min(best, sc);
         beta = std::min(beta, sc);
-        if (beta <= alpha) {
-          ttStore(hash, best, depth, EntryType::UPPER_BOUND);
-          wroteTT = true;
-          break;
-        }
+      }
+      if (beta <= alpha) {
+        cutoff = true;
+        break;
       }
     }
-    if (interrupted) {
-      if (best == std::numeric_limits<double>::max())
-        return evaluateBitboard(bitboard, isBlack);
-      return best;
-    }
-    if (!interrupted && !wroteTT) {
-      if (best <= alphaOrig)
-        eType = EntryType::UPPER_BOUND;
-      else if (best >= betaOrig)
-        eType = EntryType::LOWER_BOUND;
-      else
-        eType = EntryType::EXACT;
-      ttStore(hash, best, depth, eType);
-    }
+  }
+  // A child cut short by the clock returns a guess, which must not reach
+  // the table that later moves read
+  if (interrupted || searchClock.stopped() || isCancelled(parent)) {
+    if (best == worst)
+      return evaluateBitboard(bitboard, isBlack);
     return best;
   }
+
+  EntryType eType;
+  if (cutoff)
+    eType = isMaximizing ? EntryType::LOWER_BOUND : EntryType::UPPER_BOUND;
+  else if (best <= alphaOrig)
+    eType = EntryType::UPPER_BOUND;
+  else if (best >= betaOrig)
+    eType = EntryType::LOWER_BOUND;
+  else
+    eType = EntryType::EXACT;
+  ttStore(hash, best, depth, eType);
+  return best;
 }
 
-inline double BitBoardAIAgent::evaluateBitboard(const BitBoard &bitboard,
-                                                bool isBlack) const {
-  double sc = 0.0;
-  sc += evaluateCornerControlBitboard(bitboard, isBlack) * 25.0;
-  sc += evaluateEdgeControlBitboard(bitboard, isBlack) * 5.0;
-  sc += evaluateMobilityBitboard(bitboard, isBlack) * 15.0;
-  sc += evaluateDiscCountBitboard(bitboard, isBlack) * 5.0;
-  sc += evaluateStabilityBitboard(bitboard, isBlack) * 10.0;
+bool BitBoardAIAgent::searchYoungerBrothers(
+    const BitBoard &bitboard, const MoveList &moves, int depth, Score alpha,
+    Score beta, bool isBlack, bool isMaximizing, Score &best, bool &cutoff,
+    const SplitPoint *parent) {
+  SplitPoint split;
+  split.parent = parent;
+  split.alpha = alpha;
+  split.beta = beta;
+  split.best = best;
+  bool sideToMoveBlack = (isMaximizing ? isBlack : !isBlack);
+
+  TaskPool::Group group;
+  for (int i = 1; i < moves.size(); ++i) {
+    int square = moves.square(i);
+    pool->submit(group, [this, &split, bitboard, square, sideToMoveBlack,
+                         depth, isBlack, isMaximizing]() {
+      if (isCancelled(&split))
+        return;
+      SearchClock &threadClock = clockFor(TaskPool::currentThread());
+      BitBoard child = bitboard;
+      BitBoard::Undo undo;
+      if (!child.makeMove(square, sideToMoveBlack, undo))
+        return;
+
+      Score alpha, beta;
+      {
+        std::lock_guard<std::mutex> lock(split.mutex);
+        alpha = split.alpha;
+        beta = split.beta;
+      }
+      Score sc = bitboardMinMax(child, depth - 1, alpha, beta, isBlack,
+                                !isMaximizing, threadClock, &split);
+
+      std::lock_guard<std::mutex> lock(split.mutex);
+      if (threadClock.stopped()) {
+        split.interrupted = true;
+        return;
+      }
+      // Cut short by a brother's cutoff or higher up, the score means nothing
+      if (isCancelled(&split))
+        return;
+      if (isMaximizing) {
+        split.best = std::max(split.best, sc);
+        split.alpha = std::max(split.alpha, sc);
+      } else {
+        split.best = std::min(split.best, sc);
+        split.beta = std::min(split.beta, sc);
+      }
+      if (split.beta <= split.alpha) {
+        split.cutoff = true;
+        split.cancelled.store(true, std::memory_order_relaxed);
+      }
+    });
+  }
+  pool->wait(group);
+
+  best = split.best;
+  cutoff = split.cutoff;
+  return split.interrupted || isCancelled(parent);
+}
+
+inline Score BitBoardAIAgent::evaluateBitboard(const BitBoard &bitboard,
+                                               bool isBlack) const {
+  Score sc = 0;
+  sc += evaluateCornerControlBitboard(bitboard, isBlack) * 25;
+  sc += evaluateEdgeControlBitboard(bitboard, isBlack) * 5;
+  sc += evaluateMobilityBitboard(bitboard, isBlack) * 15;
+  sc += evaluateDiscCountBitboard(bitboard, isBlack) * 5;
+  sc += evaluateStabilityBitboard(bitboard, isBlack) * 10;
   int discs = bitboard.getTotalDiscs();
   const auto &table = (discs < 20)   ? EARLY_GAME_VALUES
                       : (discs > 50) ? LATE_GAME_VALUES
@@ -231,15 +303,15 @@ inline double BitBoardAIAgent::evaluateBitboard(const BitBoard &bitboard,
     for (int c = 0; c < 8; ++c) {
       int st = bitboard.getCell(r, c);
       if (st == (isBlack ? 1 : 2))
-        sc += table[r][c];
+        sc += table[r][c] * SCORE_SCALE;
       else if (st == (isBlack ? 2 : 1))
-        sc -= table[r][c];
+        sc -= table[r][c] * SCORE_SCALE;
     }
   }
   return sc;
 }
 
-inline double
+inline Score
 BitBoardAIAgent::evaluateCornerControlBitboard(const BitBoard &bb,
                                                bool isBlack) const {
   uint64_t corners = bb.getCornerMask();
@@ -247,31 +319,31 @@ BitBoardAIAgent::evaluateCornerControlBitboard(const BitBoard &bb,
   uint64_t opponent = bb.getOpponentBoard(isBlack);
   int pc = __builtin_popcountll(player & corners);
   int oc = __builtin_popcountll(opponent & corners);
-  return static_cast<double>(pc - oc);
+  return (pc - oc) * SCORE_SCALE;
 }
 
-inline double BitBoardAIAgent::evaluateEdgeControlBitboard(const BitBoard &bb,
-                                                           bool isBlack) const {
+inline Score BitBoardAIAgent::evaluateEdgeControlBitboard(const BitBoard &bb,
+                                                          bool isBlack) const {
   uint64_t edges = bb.getEdgeMask();
   uint64_t player = bb.getPlayerBoard(isBlack);
   uint64_t opponent = bb.getOpponentBoard(isBlack);
   int pe = __builtin_popcountll(player & edges);
   int oe = __builtin_popcountll(opponent & edges);
-  return static_cast<double>(pe - oe);
+  return (pe - oe) * SCORE_SCALE;
 }
 
-inline double BitBoardAIAgent::evaluateMobilityBitboard(const BitBoard &bb,
-                                                        bool isBlack) const {
-  int pMoves = bb.getValidMoves(isBlack).size();
-  int oMoves = bb.getValidMoves(!isBlack).size();
+inline Score BitBoardAIAgent::evaluateMobilityBitboard(const BitBoard &bb,
+                                                       bool isBlack) const {
+  int pMoves = __builtin_popcountll(bb.legalMovesMask(isBlack));
+  int oMoves = __builtin_popcountll(bb.legalMovesMask(!isBlack));
   if (pMoves + oMoves == 0)
-    return 0.0;
-  return static_cast<double>(pMoves - oMoves) / (pMoves + oMoves);
+    return 0;
+  return (pMoves - oMoves) * SCORE_SCALE / (pMoves + oMoves);
 }
 
-inline double BitBoardAIAgent::evaluateStabilityBitboard(const BitBoard &bb,
-                                                         bool isBlack) const {
-  double sc = 0.0;
+inline Score BitBoardAIAgent::evaluateStabilityBitboard(const BitBoard &bb,
+                                                        bool isBlack) const {
+  Score sc = 0;
   uint64_t player = bb.getPlayerBoard(isBlack);
   uint64_t tmp = player;
   while (tmp) {
@@ -295,19 +367,19 @@ inline double BitBoardAIAgent::evaluateStabilityBitboard(const BitBoard &bb,
       if (adjacentCorner)
         break;
     }
-    sc += adjacentCorner ? -2.0 : 1.0;
+    sc += adjacentCorner ? -2 * SCORE_SCALE : SCORE_SCALE;
   }
   return sc;
 }
 
-inline double BitBoardAIAgent::evaluateDiscCountBitboard(const BitBoard &bb,
-                                                         bool isBlack) const {
+inline Score BitBoardAIAgent::evaluateDiscCountBitboard(const BitBoard &bb,
+                                                        bool isBlack) const {
   int p = bb.getScore(isBlack);
   int o = bb.getScore(!isBlack);
   int t = bb.getTotalDiscs();
   if (t == 0)
-    return 0.0;
-  return static_cast<double>(p - o) / t;
+    return 0;
+  return (p - o) * SCORE_SCALE / t;
 }
 
 inline uint64_t BitBoardAIAgent::getZobristHash(const BitBoard &bb,
@@ -315,67 +387,18 @@ inline uint64_t BitBoardAIAgent::getZobristHash(const BitBoard &bb,
   return bb.getZobristHash(blackToMove);
 }
 
-const BitBoardAIAgent::TranspositionEntry *
-BitBoardAIAgent::ttLookup(uint64_t hash, int requiredDepth) const {
-  size_t idx = ttBucketIndex(hash);
-  const TTBucket &bucket = transpositionTable[idx];
-  for (size_t i = 0; i < TT_WAYS; ++i) {
-    const TranspositionEntry &e = bucket.entries[i];
-    if (e.hash == hash && e.depth >= requiredDepth) {
-      return &e;
-    }
-  }
-  return nullptr;
+bool BitBoardAIAgent::ttLookup(uint64_t hash, int requiredDepth,
+                               TTEntry &entry) const {
+  return transpositionTable.probe(hash, entry) && entry.depth >= requiredDepth;
 }
 
-void BitBoardAIAgent::ttStore(uint64_t hash, double score, int depth,
+void BitBoardAIAgent::ttStore(uint64_t hash, Score score, int depth,
                               EntryType type) const {
-  size_t idx = ttBucketIndex(hash);
-  TTBucket &bucket = const_cast<TTBucket &>(transpositionTable[idx]);
-  for (size_t i = 0; i < TT_WAYS; ++i) {
-    TranspositionEntry &e = bucket.entries[i];
-    if (e.hash == hash) {
-      if (depth >= e.depth) {
-        e = TranspositionEntry(hash, score, depth, type);
-      }
-      return;
-    }
-  }
-  for (size_t i = 0; i < TT_WAYS; ++i) {
-    TranspositionEntry &e = bucket.entries[i];
-    if (e.hash == 0) {
-      e = TranspositionEntry(hash, score, depth, type);
-      return;
-    }
-  }
-  size_t victimIdx = 0;
-  int minDepth = bucket.entries[0].depth;
-  for (size_t i = 1; i < TT_WAYS; ++i) {
-    if (bucket.entries[i].depth < minDepth) {
-      minDepth = bucket.entries[i].depth;
-      victimIdx = i;
-    }
-  }
-  bucket.entries[victimIdx] = TranspositionEntry(hash, score, depth, type);
-}
-
-inline void BitBoardAIAgent::clearTranspositionTable() {
-  for (auto &bucket : transpositionTable) {
-    for (size_t i = 0; i < TT_WAYS; ++i) {
-      bucket.entries[i] = TranspositionEntry();
-    }
-  }
+  transpositionTable.store(hash, score, depth, type);
 }
 
 inline size_t BitBoardAIAgent::getTranspositionTableSize() const {
-  size_t count = 0;
-  for (const auto &bucket : transpositionTable) {
-    for (size_t i = 0; i < TT_WAYS; ++i) {
-      if (bucket.entries[i].hash != 0)
-        ++count;
-    }
-  }
-  return count;
+  return transpositionTable.entries();
 }
 
 inline bool BitBoardAIAgent::isBlackPlayer(CellState p) const {
@@ -386,47 +409,46 @@ inline CellState BitBoardAIAgent::playerFromBool(bool isBlack) const {
   return isBlack ? CellState::BLACK : CellState::WHITE;
 }
 
-inline std::vector<std::pair<int, int>>
-BitBoardAIAgent::orderMoves(const BitBoard &bb,
-                            const std::vector<std::pair<int, int>> &moves,
-                            bool isBlack) const {
-  std::vector<std::pair<std::pair<int, int>, double>> moveScores;
-  for (const auto &mv : moves) {
-    double score = 0.0;
+inline void BitBoardAIAgent::orderMoves(const BitBoard &bb, MoveList &moves,
+                                        bool isBlack, bool rootIsBlack) const {
+  const uint64_t rootKey = rootIsBlack ? BLACK_ROOT_KEY : 0;
+  for (int i = 0; i < moves.size(); ++i) {
+    const auto mv = moves[i];
+    int score = 0;
     if ((mv.first == 0 || mv.first == 7) && (mv.second == 0 || mv.second == 7))
-      score += 1000.0;
+      score += 1000;
     else if (((mv.first == 0 || mv.first == 7) &&
               (mv.second == 1 || mv.second == 6)) ||
              ((mv.first == 1 || mv.first == 6) &&
               (mv.second == 0 || mv.second == 7)))
-      score -= 500.0;
+      score -= 500;
     else if (mv.first == 0 || mv.first == 7 || mv.second == 0 || mv.second == 7)
-      score += 100.0;
-    BitBoard tmp = bb;
-    int before = bb.getScore(isBlack);
-    if (tmp.makeMove(mv.first, mv.second, isBlack)) {
-      int after = tmp.getScore(isBlack);
-      int flips = after - before - 1;
-      if (flips > 0)
-        score += flips * 10.0;
-    }
-    moveScores.emplace_back(mv, score);
+      score += 100;
+    uint64_t flips = bb.flipsMask(moves.square(i), isBlack);
+    transpositionTable.prefetch(
+        bb.getZobristHashAfter(moves.square(i), flips, isBlack, !isBlack) ^
+        rootKey);
+    score += __builtin_popcountll(flips) * 10;
+    moves.setScore(i, score);
   }
-  std::sort(moveScores.begin(), moveScores.end(),
-            [](const auto &a, const auto &b) { return a.second > b.second; });
-  std::vector<std::pair<int, int>> ordered;
-  ordered.reserve(moveScores.size());
-  for (const auto &ms : moveScores)
-    ordered.push_back(ms.first);
-  return ordered;
+  moves.sortByScore();
 }
 
 REGISTER_AI_AGENT(BitBoardAIAgent, "bitboard")
 
-bool BitBoardAIAgent::isTimeUp(std::chrono::steady_clock::time_point startTime,
-                               std::chrono::milliseconds timeLimit) const {
-  auto now = std::chrono::steady_clock::now();
-  auto elapsed =
-      std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime);
-  return elapsed + std::chrono::milliseconds{3} >= timeLimit;
-}
+namespace {
+// Parallel search on every core, for hosts that play one game at a time
+class BitBoardSmpFactory {
+public:
+  BitBoardSmpFactory() {
+    registerAIAgent("bitboard_smp", [](const std::string &name,
+                                       const std::string &author)
+                                        -> std::unique_ptr<AIAgentBase> {
+      int cores = static_cast<int>(std::thread::hardware_concurrency());
+      return std::make_unique<BitBoardAIAgent>(name, author, 8,
+                                               std::max(1, cores));
+    });
+  }
+};
+static BitBoardSmpFactory BitBoardSmpFactoryInstance;
+} // namespace
@@ -1,14 +1,175 @@
 #pragma GCC optimize("-Ofast,inline,omit-frame-pointer,unroll-loops,fast-math")
 #include "mcts_ai_agent.h"
 
-MCTSAiAgent::MCTSAiAgent(const std::string &name, const std::string &author)
-    : AIAgentBase(name, author), mcts_(1'000'000, 14785) {}
+MCTSAiAgent::MCTSAiAgent(const std::string &name, const std::string &author,
+                         int threads, bool root_parallel)
+    : AIAgentBase(name, author) {
+  // About 9.6M nodes; the pools' pages are faulted in by onGameStart, not
+  // here
+  constexpr size_t TREE_MEMORY = size_t{128} << 20;
+  constexpr uint32_t NODES = TREE_MEMORY / mcts::Mcts::BYTES_PER_NODE;
+  constexpr uint64_t SEED = 14785;
+  threads = std::max(threads, 1);
+  if (root_parallel) {
+    // The same memory, split between independent trees
+    for (int i = 0; i < threads; ++i) {
+      trees_.push_back(
+          std::make_unique<mcts::Mcts>(NODES / threads, SEED + 7919 * i, 4));
+    }
+  } else {
+    trees_.push_back(std::make_unique<mcts::Mcts>(NODES, SEED, 4, threads));
+  }
+}
+
+MCTSAiAgent::~MCTSAiAgent() { stopPondering(); }
 
 std::pair<int, int>
 MCTSAiAgent::getBestMove(const Board &board, CellState player,
                          std::chrono::milliseconds timeLimit) {
+  stopPondering();
+  // Stop a few milliseconds early to leave room for returning the move
+  clock_.start(timeLimit - std::chrono::milliseconds{3});
   mcts::Game game(board, player);
-  return mcts_.best_move(game, std::chrono::steady_clock::now(), timeLimit);
+  search(game);
+  auto move = pick_move(game);
+  if (ponderingAllowed) {
+    start_pondering(game, move);
+  }
+  return move;
+}
+
+void MCTSAiAgent::search(const mcts::Game &game) {
+  std::vector<std::thread> helpers;
+  for (size_t i = 1; i < trees_.size(); ++i) {
+    helpers.emplace_back(
+        [this, &game, i]() { trees_[i]->search(game, clock_, false); });
+  }
+  trees_[0]->search(game, clock_);
+  for (auto &helper : helpers) {
+    helper.join();
+  }
+}
+
+// Root parallel search votes with the summed scores of all trees
+mcts::Game::Move MCTSAiAgent::pick_move(const mcts::Game &game) const {
+  std::vector<std::pair<mcts::Game::Move, double>> totals;
+  for (const auto &tree : trees_) {
+    for (const auto &[move, score] : tree->root_scores(game.next_player())) {
+      auto it = std::find_if(totals.begin(), totals.end(),
+                             [&](const auto &t) { return t.first == move; });
+      if (it == totals.end()) {
+        totals.emplace_back(move, score);
+      } else {
+        it->second += score;
+      }
+    }
+  }
+
+  mcts::Game::Move best_move = game.valid_moves().front();
+  double best_score = -std::numeric_limits<double>::infinity();
+  for (const auto &[move, score] : totals) {
+    if (best_score < score) {
+      best_score = score;
+      best_move = move;
+    }
+  }
+  return best_move;
+}
+
+void MCTSAiAgent::onMoveMade(int row, int col, CellState player) {
+  bool opponent_moved = (player == CellState::BLACK) != ponder_black_;
+  if (opponent_moved && std::make_pair(row, col) != ponder_reply_) {
+    stopPondering();
+  }
+}
+
+// Each tree is reset from the thread that searches it, as in search()
+void MCTSAiAgent::onGameStart() {
+  stopPondering();
+  std::vector<std::thread> helpers;
+  for (size_t i = 1; i < trees_.size(); ++i) {
+    helpers.emplace_back([this, i]() { trees_[i]->reset(); });
+  }
+  trees_[0]->reset();
+  for (auto &helper : helpers) {
+    helper.join();
+  }
+}
+
+void MCTSAiAgent::stopPondering() {
+  if (ponder_thread_.joinable()) {
+    clock_.stop();
+    ponder_thread_.join();
+  }
+}
+
+uint64_t MCTSAiAgent::getTreeNodes() const {
+  uint64_t nodes = 0;
+  for (const auto &tree : trees_) {
+    nodes += tree->node_count();
+  }
+  return nodes;
+}
+
+size_t MCTSAiAgent::getTreeMemoryUsed() const {
+  size_t bytes = 0;
+  for (const auto &tree : trees_) {
+    bytes += tree->memory_used();
+  }
+  return bytes;
+}
+
+size_t MCTSAiAgent::getTreeMemoryCapacity() const {
+  size_t bytes = 0;
+  for (const auto &tree : trees_) {
+    bytes += tree->memory_capacity();
+  }
+  return bytes;
+}
+
+void MCTSAiAgent::start_pondering(const mcts::Game &game,
+                                  mcts::Game::Move move) {
+  mcts::Game::Move reply;
+  if (!trees_[0]->predicted_reply(move, reply))
+    return;
+  mcts::Game position = game;
+  position.play(move);
+  // Only ponder when the opponent has a reply and we move after it
+  if (position.finished() || position.next_player() == game.next_player())
+    return;
+  position.play(reply);
+  if (position.finished() || position.next_player() != game.next_player())
+    return;
+
+  ponder_black_ = game.next_player();
+  ponder_reply_ = reply;
+  clock_.start(PONDER_LIMIT);
+  ponder_thread_ = std::thread([this, position]() { search(position); });
 }
 
 REGISTER_AI_AGENT(MCTSAiAgent, "mcts");
+
+namespace {
+// One thread per core, on a shared tree or on a tree each for comparison
+class MCTSAiAgentParallelFactory {
+public:
+  MCTSAiAgentParallelFactory() {
+    registerAIAgent("mcts_smp", [](const std::string &name,
+                                   const std::string &author)
+                                    -> std::unique_ptr<AIAgentBase> {
+      return std::make_unique<MCTSAiAgent>(name, author, cores());
+    });
+    registerAIAgent("mcts_root", [](const std::string &name,
+                                    const std::string &author)
+                                     -> std::unique_ptr<AIAgentBase> {
+      return std::make_unique<MCTSAiAgent>(name, author, cores(), true);
+    });
+  }
+
+private:
+  static int cores() {
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+};
+static MCTSAiAgentParallelFactory MCTSAiAgentParallelFactoryInstance;
+} // namespace
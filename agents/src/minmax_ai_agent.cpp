@@ -10,7 +10,8 @@ MinMaxAIAgent::MinMaxAIAgent(const std::string &name, const std::string &author,
 std::pair<int, int>
 MinMaxAIAgent::getBestMove(const Board &board, CellState player,
                            std::chrono::milliseconds timeLimit) {
-  auto startTime = std::chrono::steady_clock::now();
+  // Stop a few milliseconds early to leave room for returning the move
+  clock.start(timeLimit - std::chrono::milliseconds{3});
 
   auto validMoves = getValidMoves(board, player);
   if (validMoves.empty()) {
@@ -18,19 +19,17 @@ MinMaxAIAgent::getBestMove(const Board &board, CellState player,
   }
 
   std::pair<int, int> bestMove = validMoves[0];
-  double bestScore = std::numeric_limits<double>::lowest();
+  Score bestScore = -SCORE_INFINITY;
 
   for (const auto &move : validMoves) {
-    if (isTimeUp(startTime, timeLimit)) {
+    if (clock.hardTimeUp()) {
       break;
     }
 
     Board tempBoard = board;
     if (tempBoard.makeMove(move.first, move.second, player)) {
-      double score =
-          minMax(tempBoard, maxDepth - 1, std::numeric_limits<double>::lowest(),
-                 std::numeric_limits<double>::max(), player, false, startTime,
-                 timeLimit);
+      Score score = minMax(tempBoard, maxDepth - 1, -SCORE_INFINITY,
+                           SCORE_INFINITY, player, false);
 
       if (score > bestScore) {
         bestScore = score;
@@ -42,35 +41,37 @@ MinMaxAIAgent::getBestMove(const Board &board, CellState player,
   return bestMove;
 }
 
-double MinMaxAIAgent::minMax(Board &board, int depth, double alpha, double beta,
-                             CellState player, bool isMaximizing,
-                             std::chrono::steady_clock::time_point startTime,
-                             std::chrono::milliseconds timeLimit) {
-  if (isTimeUp(startTime, timeLimit)) {
-    return 0.0;
+Score MinMaxAIAgent::minMax(Board &board, int depth, Score alpha, Score beta,
+                            CellState player, bool isMaximizing) {
+  if (clock.timeUp()) {
+    return 0;
   }
 
-  if (depth == 0 || board.isGameOver()) {
+  if (board.isGameOver()) {
+    return finalScore(board.getScore(player),
+                      board.getScore(getOpponent(player)));
+  }
+  if (depth == 0) {
     return evaluateBoard(board, player);
   }
 
-  auto validMoves =
-      getValidMoves(board, isMaximizing ? player : getOpponent(player));
+  MoveList validMoves;
+  board.getValidMoves(isMaximizing ? player : getOpponent(player), validMoves);
   if (validMoves.empty()) {
     return evaluateBoard(board, player);
   }
 
   if (isMaximizing) {
-    double maxScore = std::numeric_limits<double>::lowest();
-    for (const auto &move : validMoves) {
-      if (isTimeUp(startTime, timeLimit)) {
+    Score maxScore = -SCORE_INFINITY;
+    for (int i = 0; i < validMoves.size(); ++i) {
+      const auto move = validMoves[i];
+      if (clock.timeUp()) {
         break;
       }
 
       Board tempBoard = board;
       if (tempBoard.makeMove(move.first, move.second, player)) {
-        double score = minMax(tempBoard, depth - 1, alpha, beta, player, false,
-                              startTime, timeLimit);
+        Score score = minMax(tempBoard, depth - 1, alpha, beta, player, false);
         maxScore = std::max(maxScore, score);
         alpha = std::max(alpha, score);
         if (beta <= alpha)
@@ -79,16 +80,16 @@ double MinMaxAIAgent::minMax(Board &board, int depth, double alpha, double beta,
     }
     return maxScore;
   } else {
-    double minScore = std::numeric_limits<double>::max();
-    for (const auto &move : validMoves) {
-      if (isTimeUp(startTime, timeLimit)) {
+    Score minScore = SCORE_INFINITY;
+    for (int i = 0; i < validMoves.size(); ++i) {
+      const auto move = validMoves[i];
+      if (clock.timeUp()) {
         break;
       }
 
       Board tempBoard = board;
       if (tempBoard.makeMove(move.first, move.second, getOpponent(player))) {
-        double score = minMax(tempBoard, depth - 1, alpha, beta, player, true,
-                              startTime, timeLimit);
+        Score score = minMax(tempBoard, depth - 1, alpha, beta, player, true);
         minScore = std::min(minScore, score);
         beta = std::min(beta, score);
         if (beta <= alpha)
@@ -99,9 +100,9 @@ double MinMaxAIAgent::minMax(Board &board, int depth, double alpha, double beta,
   }
 }
 
-double MinMaxAIAgent::evaluateBoard(const Board &board,
-                                    CellState player) const {
-  double score = 0.0;
+Score MinMaxAIAgent::evaluateBoard(const Board &board,
+                                   CellState player) const {
+  Score score = 0;
 
   score += evaluateCornerControl(board, player);
   score += evaluateEdgeControl(board, player);
@@ -112,79 +113,82 @@ double MinMaxAIAgent::evaluateBoard(const Board &board,
   return score;
 }
 
-double MinMaxAIAgent::evaluateCornerControl(const Board &board,
-                                            CellState player) const {
+Score MinMaxAIAgent::evaluateCornerControl(const Board &board,
+                                           CellState player) const {
   static const std::vector<std::pair<int, int>> corners = {
       {0, 0}, {0, 7}, {7, 0}, {7, 7}};
 
-  double score = 0.0;
+  Score score = 0;
   for (const auto &corner : corners) {
     CellState cellState = board.getCell(corner.first, corner.second);
     if (cellState == player) {
-      score += 25.0;
+      score += 25 * SCORE_SCALE;
     } else if (cellState == getOpponent(player)) {
-      score -= 25.0;
+      score -= 25 * SCORE_SCALE;
     }
   }
   return score;
 }
 
-double MinMaxAIAgent::evaluateEdgeControl(const Board &board,
-                                          CellState player) const {
-  double score = 0.0;
+Score MinMaxAIAgent::evaluateEdgeControl(const Board &board,
+                                         CellState player) const {
+  Score score = 0;
 
   for (int i = 1; i < 7; ++i) {
     if (board.getCell(0, i) == player)
-      score += 5.0;
+      score += 5 * SCORE_SCALE;
     else if (board.getCell(0, i) == getOpponent(player))
-      score -= 5.0;
+      score -= 5 * SCORE_SCALE;
 
     if (board.getCell(7, i) == player)
-      score += 5.0;
+      score += 5 * SCORE_SCALE;
     else if (board.getCell(7, i) == getOpponent(player))
-      score -= 5.0;
+      score -= 5 * SCORE_SCALE;
 
     if (board.getCell(i, 0) == player)
-      score += 5.0;
+      score += 5 * SCORE_SCALE;
     else if (board.getCell(i, 0) == getOpponent(player))
-      score -= 5.0;
+      score -= 5 * SCORE_SCALE;
 
     if (board.getCell(i, 7) == player)
-      score += 5.0;
+      score += 5 * SCORE_SCALE;
     else if (board.getCell(i, 7) == getOpponent(player))
-      score -= 5.0;
+      score -= 5 * SCORE_SCALE;
   }
 
   return score;
 }
 
-double MinMaxAIAgent::evaluateMobility(const Board &board,
-                                       CellState player) const {
-  int playerMoves = board.getValidMoves(player).size();
-  int opponentMoves = board.getValidMoves(getOpponent(player)).size();
+Score MinMaxAIAgent::evaluateMobility(const Board &board,
+                                      CellState player) const {
+  MoveList moves;
+  board.getValidMoves(player, moves);
+  int playerMoves = moves.size();
+  board.getValidMoves(getOpponent(player), moves);
+  int opponentMoves = moves.size();
 
   if (playerMoves + opponentMoves == 0)
-    return 0.0;
+    return 0;
 
-  return static_cast<double>(playerMoves - opponentMoves) /
-         (playerMoves + opponentMoves) * 15.0;
+  return (playerMoves - opponentMoves) * 15 * SCORE_SCALE /
+         (playerMoves + opponentMoves);
 }
 
-double MinMaxAIAgent::evaluateDiscCount(const Board &board,
-                                        CellState player) const {
+Score MinMaxAIAgent::evaluateDiscCount(const Board &board,
+                                       CellState player) const {
   int playerDiscs = board.getScore(player);
   int opponentDiscs = board.getScore(getOpponent(player));
   int totalDiscs = board.getTotalDiscs();
 
   if (totalDiscs == 0)
-    return 0.0;
+    return 0;
 
-  return static_cast<double>(playerDiscs - opponentDiscs) / totalDiscs * 5.0;
+  return (playerDiscs - opponentDiscs) * 5 * SCORE_SCALE / totalDiscs;
 }
 
-double MinMaxAIAgent::evaluateStability(const Board &board,
-                                        CellState player) const {
-  double score = 0.0;
+Score MinMaxAIAgent::evaluateStability(const Board &board,
+                                       CellState player) const {
+  Score score = 0;
 
   for (int row = 0; row < 8; ++row) {
     for (int col = 0; col < 8; ++col) {
@@ -206,23 +210,15 @@ double MinMaxAIAgent::evaluateStability(const Board &board,
         }
 
         if (adjacentToCorner) {
-          score -= 2.0;
+          score -= 2;
         } else {
-          score += 1.0;
+          score += 1;
         }
       }
     }
   }
 
-  return score * 10.0;
+  return score * 10 * SCORE_SCALE;
 }
 
 REGISTER_AI_AGENT(MinMaxAIAgent, "minmax")
-
-bool MinMaxAIAgent::isTimeUp(std::chrono::steady_clock::time_point startTime,
-                             std::chrono::milliseconds timeLimit) const {
-  auto now = std::chrono::steady_clock::now();
-  auto elapsed =
-      std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime);
-  return elapsed + std::chrono::milliseconds{3} >= timeLimit;
-}
@@ -1,8 +1,20 @@
 #include "panda_ai_agent.h"
 #include <algorithm>
-#include <cmath>
+#include <functional>
 #include <random>
 
+namespace {
+// What a fail-soft score searched with the window alpha..beta tells about
+// the node's value
+TTBound boundOf(Score score, Score alpha, Score beta) {
+  if (score <= alpha)
+    return TTBound::UPPER_BOUND;
+  if (score >= beta)
+    return TTBound::LOWER_BOUND;
+  return TTBound::EXACT;
+}
+} // namespace
+
 const std::array<std::array<int, 8>, 8> PandaAIAgent::POSITION_VALUES = {
     {{{120, -20, 20, 5, 5, 20, -20, 120}},
      {{-20, -40, -5, -5, -5, -5, -40, -20}},
@@ -34,24 +46,28 @@ const std::array<std::array<int, 8>, 8> PandaAIAgent::ENDGAME_VALUES = {
      {{100, 50, 30, 20, 20, 30, 50, 100}}}};
 
 PandaAIAgent::PandaAIAgent(const std::string &name, const std::string &author,
-                           int depth)
-    : AIAgentBase(name, author), maxDepth(depth), nodesSearched(0) {
-  transpositionTable.resize(TT_SIZE);
-}
+                           int depth, int threads)
+    : AIAgentBase(name, author), maxDepth(depth),
+      threads(std::max(1, threads)),
+      helperClocks(new SearchClock[this->threads - 1]) {}
+
+PandaAIAgent::~PandaAIAgent() { stopPondering(); }
 
 std::pair<int, int>
 PandaAIAgent::getBestMove(const Board &board, CellState player,
                           std::chrono::milliseconds timeLimit) {
-  auto startTime = std::chrono::steady_clock::now();
-  nodesSearched = 0;
+  // On a ponder hit the table is now warm for this very position
+  stopPondering();
+  transpositionTable.newSearch();
 
   for (int i = 0; i < 64; ++i)
     historyTable[i] = 0;
 
-  BitBoard bitboard = boardToBitboard(board);
+  BitBoard bitboard = getBitBoard(board);
   bool isBlack = (player == CellState::BLACK);
 
-  auto validMoves = bitboard.getValidMoves(isBlack);
+  MoveList validMoves;
+  bitboard.getValidMoves(isBlack, validMoves);
   if (validMoves.empty()) {
     return {-1, -1};
   }
@@ -67,26 +83,81 @@ PandaAIAgent::getBestMove(const Board &board, CellState player,
     }
   }
 
-  return iterativeDeepeningSearch(bitboard, isBlack, startTime, timeLimit);
+  int emptySquares = 64 - bitboard.getTotalDiscs();
+  if (emptySquares <= ENDGAME_DEPTH) {
+    // Solve with a 5% safety margin
+    clock.start(timeLimit * 95 / 100);
+  } else {
+    // Don't start a depth after half the time, and give up on one at 80%
+    clock.start(timeLimit / 2, timeLimit * 4 / 5);
+  }
+
+  auto bestMove = iterativeDeepeningSearch(bitboard, isBlack);
+  if (ponderingAllowed) {
+    startPondering(bitboard, bestMove, isBlack);
+  }
+  return bestMove;
 }
 
-BitBoard PandaAIAgent::boardToBitboard(const Board &board) const {
-  BitBoard bitboard;
-  bitboard.blackBoard = 0;
-  bitboard.whiteBoard = 0;
+// The table outlives moves and games alike; see TranspositionTable::newGame
+void PandaAIAgent::onGameStart() {
+  stopPondering();
+  transpositionTable.newGame(threads);
+}
 
-  for (int row = 0; row < 8; ++row) {
-    for (int col = 0; col < 8; ++col) {
-      CellState cell = board.getCell(row, col);
-      if (cell == CellState::BLACK) {
-        bitboard.setCell(row, col, 1);
-      } else if (cell == CellState::WHITE) {
-        bitboard.setCell(row, col, 2);
-      }
-    }
+Score PandaAIAgent::searchToDepth(const BitBoard &position, bool isBlack,
+                                  int depth) {
+  stopPondering();
+  transpositionTable.newSearch();
+  historyTable.fill(0);
+  BitBoard bitboard = position;
+  clock.start(PONDER_LIMIT);
+  return negamax(bitboard, depth, -SCORE_INFINITY, SCORE_INFINITY, isBlack,
+                 clock);
+}
+
+void PandaAIAgent::onMoveMade(int row, int col, CellState player) {
+  bool opponentMoved = (player == CellState::BLACK) != ponderIsBlack;
+  if (opponentMoved && std::make_pair(row, col) != ponderReply) {
+    stopPondering();
+  }
+}
+
+void PandaAIAgent::stopPondering() {
+  if (ponderThread.joinable()) {
+    clock.stop();
+    ponderThread.join();
   }
+}
 
-  return bitboard;
+// Searches the position after our move and the reply the table expects, so
+// a ponder hit finds its transposition table entries already deep
+void PandaAIAgent::startPondering(const BitBoard &bitboard,
+                                  std::pair<int, int> move, bool isBlack) {
+  BitBoard position = bitboard;
+  if (!position.makeMove(move.first, move.second, isBlack))
+    return;
+
+  TranspositionTable::Entry entry;
+  if (!transpositionTable.probe(position.getZobristHash(!isBlack), entry) ||
+      entry.move == TranspositionTable::NO_MOVE)
+    return;
+  std::pair<int, int> reply{entry.move / 8, entry.move % 8};
+  if (!position.makeMove(reply.first, reply.second, !isBlack))
+    return;
+
+  // The endgame solver keeps nothing in the table, so there is nothing to
+  // warm up; and there's no search to run if we'd have to pass
+  if (64 - position.getTotalDiscs() <= ENDGAME_DEPTH ||
+      !position.hasValidMoves(isBlack))
+    return;
+
+  ponderIsBlack = isBlack;
+  ponderReply = reply;
+  clock.start(PONDER_LIMIT);
+  ponderThread = std::thread([this, position, isBlack]() mutable {
+    iterativeDeepeningSearch(position, isBlack);
+  });
 }
 
 PandaAIAgent::GamePhase
@@ -100,31 +171,26 @@ PandaAIAgent::getGamePhase(const BitBoard &bitboard) const {
   return GamePhase::MIDGAME;
 }
 
-std::pair<int, int> PandaAIAgent::iterativeDeepeningSearch(
-    const BitBoard &bitboard, bool isBlack,
-    std::chrono::steady_clock::time_point startTime,
-    std::chrono::milliseconds timeLimit) {
+std::pair<int, int> PandaAIAgent::iterativeDeepeningSearch(BitBoard &bitboard,
+                                                           bool isBlack) {
 
-  auto validMoves = bitboard.getValidMoves(isBlack);
+  MoveList validMoves;
+  bitboard.getValidMoves(isBlack, validMoves);
   std::pair<int, int> bestMove = validMoves[0];
-  double bestScore = -std::numeric_limits<double>::infinity();
-
-  auto searchTimeLimit =
-      std::chrono::milliseconds(static_cast<long>(timeLimit.count() * 0.80));
+  Score bestScore = -SCORE_INFINITY;
 
   int emptySquares = 64 - bitboard.getTotalDiscs();
   if (emptySquares <= ENDGAME_DEPTH) {
-    bool timeUp = false;
-
-    for (const auto &move : validMoves) {
-      if (isTimeUp(startTime, timeLimit))
+    for (int i = 0; i < validMoves.size(); ++i) {
+      const auto move = validMoves[i];
+      if (clock.hardTimeUp())
         break;
 
-      BitBoard tempBoard = bitboard;
-      if (tempBoard.makeMove(move.first, move.second, isBlack)) {
-        double score =
-            -exactEndgameSearch(tempBoard, !isBlack, emptySquares - 1,
-                                startTime, timeLimit, timeUp);
+      BitBoard::Undo undo;
+      if (bitboard.makeMove(validMoves.square(i), isBlack, undo)) {
+        Score score =
+            -exactEndgameSearch(bitboard, !isBlack, emptySquares - 1);
+        bitboard.unmakeMove(undo);
         if (score > bestScore) {
           bestScore = score;
           bestMove = move;
@@ -134,20 +200,30 @@ std::pair<int, int> PandaAIAgent::iterativeDeepeningSearch(
     return bestMove;
   }
 
+  std::vector<std::thread> helpers;
+  for (int i = 1; i < threads; ++i) {
+    // Helpers have no deadline of their own, this search stops them
+    SearchClock &helperClock = helperClocks[i - 1];
+    helperClock.start(PONDER_LIMIT);
+    helpers.emplace_back(&PandaAIAgent::helperSearch, this, bitboard, isBlack,
+                         1 + i % 2, std::ref(helperClock));
+  }
+
   for (int depth = 1; depth <= maxDepth; ++depth) {
-    if (isTimeUp(startTime, searchTimeLimit))
+    if (!clock.nextIterationFits())
       break;
 
-    double iterationBestScore = -std::numeric_limits<double>::infinity();
+    Score iterationBestScore = -SCORE_INFINITY;
     std::pair<int, int> iterationBestMove = validMoves[0];
     bool timeUp = false;
 
-    auto orderedMoves = orderMoves(bitboard, validMoves, isBlack, bestMove);
+    MoveList orderedMoves = validMoves;
+    orderMoves(bitboard, orderedMoves, isBlack, bestMove);
 
-    double baseAlpha = -std::numeric_limits<double>::infinity();
-    double baseBeta = std::numeric_limits<double>::infinity();
-    const double aspWindow = 50.0;
-    if (depth > 1 && !std::isinf(bestScore)) {
+    Score baseAlpha = -SCORE_INFINITY;
+    Score baseBeta = SCORE_INFINITY;
+    const Score aspWindow = 50 * SCORE_SCALE;
+    if (depth > 1 && bestScore != -SCORE_INFINITY) {
       baseAlpha = bestScore - aspWindow;
       baseBeta = bestScore + aspWindow;
     }
@@ -157,24 +233,25 @@ std::pair<int, int> PandaAIAgent::iterativeDeepeningSearch(
     bool complete = false;
     while (!complete && attempts < maxAttempts) {
       attempts++;
-      double alpha = baseAlpha;
-      double beta = baseBeta;
+      Score alpha = baseAlpha;
+      Score beta = baseBeta;
 
-      iterationBestScore = -std::numeric_limits<double>::infinity();
+      iterationBestScore = -SCORE_INFINITY;
       iterationBestMove = orderedMoves[0];
       timeUp = false;
 
-      for (const auto &move : orderedMoves) {
-        if (isTimeUp(startTime, searchTimeLimit)) {
+      for (int i = 0; i < orderedMoves.size(); ++i) {
+        const auto move = orderedMoves[i];
+        if (clock.hardTimeUp()) {
           timeUp = true;
           break;
         }
 
-        BitBoard tempBoard = bitboard;
-        if (tempBoard.makeMove(move.first, move.second, isBlack)) {
-          bool searchTimeUp = false;
-          double score = -negamax(tempBoard, depth - 1, -beta, -alpha, !isBlack,
-                                  startTime, searchTimeLimit, searchTimeUp);
+        BitBoard::Undo undo;
+        if (bitboard.makeMove(orderedMoves.square(i), isBlack, undo)) {
+          Score score =
+              -negamax(bitboard, depth - 1, -beta, -alpha, !isBlack, clock);
+          bitboard.unmakeMove(undo);
 
           if (score > iterationBestScore) {
             iterationBestScore = score;
@@ -188,14 +265,16 @@ std::pair<int, int> PandaAIAgent::iterativeDeepeningSearch(
         }
       }
 
+      // The last root move may have been cut short too
+      timeUp = timeUp || clock.stopped();
       if (timeUp)
         break;
 
       if (iterationBestScore <= baseAlpha) {
-        baseAlpha -= aspWindow * 2.0;
+        baseAlpha -= aspWindow * 2;
         continue;
       } else if (iterationBestScore >= baseBeta) {
-        baseBeta += aspWindow * 2.0;
+        baseBeta += aspWindow * 2;
         continue;
       } else {
         complete = true;
@@ -205,17 +284,28 @@ std::pair<int, int> PandaAIAgent::iterativeDeepeningSearch(
     if (!timeUp) {
       bestScore = iterationBestScore;
       bestMove = iterationBestMove;
+      clock.iterationDone();
     }
   }
 
+  for (int i = 1; i < threads; ++i) {
+    helperClocks[i - 1].stop();
+  }
+  for (auto &helper : helpers) {
+    helper.join();
+  }
+
   return bestMove;
 }
 
-bool PandaAIAgent::isTimeUp(std::chrono::steady_clock::time_point startTime,
-                            std::chrono::milliseconds timeLimit) const {
-  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-      std::chrono::steady_clock::now() - startTime);
-  return elapsed >= timeLimit;
+void PandaAIAgent::helperSearch(BitBoard bitboard, bool isBlack,
+                                int firstDepth, SearchClock &helperClock) {
+  for (int depth = firstDepth; depth <= maxDepth; ++depth) {
+    negamax(bitboard, depth, -SCORE_INFINITY, SCORE_INFINITY, isBlack,
+            helperClock);
+    if (helperClock.stopped())
+      break;
+  }
 }
 
 bool PandaAIAgent::isCorner(int row, int col) const {
@@ -226,145 +316,143 @@ bool PandaAIAgent::isEdge(int row, int col) const {
   return row == 0 || row == 7 || col == 0 || col == 7;
 }
 
-double PandaAIAgent::negamax(BitBoard &bitboard, int depth, double alpha,
-                             double beta, bool isBlack,
-                             std::chrono::steady_clock::time_point startTime,
-                             std::chrono::milliseconds timeLimit,
-                             bool &timeUp) {
-  nodesSearched++;
-
-  if (nodesSearched % 256 == 0 && isTimeUp(startTime, timeLimit)) {
-    timeUp = true;
-    return 0.0;
+Score PandaAIAgent::negamax(BitBoard &bitboard, int depth, Score alpha,
+                            Score beta, bool isBlack,
+                            SearchClock &searchClock) {
+  if (searchClock.timeUp()) {
+    return 0;
   }
+  const Score alphaOrig = alpha;
 
-  uint64_t hash = bitboard.getZobristHash();
+  // With the side to move, as a pass searches the same board for the other
+  // side
+  uint64_t hash = bitboard.getZobristHash(isBlack);
   std::pair<int, int> ttMove;
-  double ttScore;
+  Score ttScore;
   if (probeTTEntry(hash, depth, alpha, beta, ttScore, ttMove)) {
     return ttScore;
   }
 
-  if (depth == 0 || bitboard.isGameOver()) {
-    double score = evaluatePosition(bitboard, isBlack);
+  if (bitboard.isGameOver()) {
+    Score score =
+        finalScore(bitboard.getScore(isBlack), bitboard.getScore(!isBlack));
+    storeTTEntry(hash, score, depth, EntryType::EXACT, {-1, -1});
+    return score;
+  }
+  if (depth == 0) {
+    Score score = evaluatePosition(bitboard, isBlack);
     storeTTEntry(hash, score, depth, EntryType::EXACT, {-1, -1});
     return score;
   }
 
-  auto validMoves = bitboard.getValidMoves(isBlack);
+  MoveList validMoves;
+  bitboard.getValidMoves(isBlack, validMoves);
   if (validMoves.empty()) {
     if (!bitboard.hasValidMoves(!isBlack)) {
-      double score = evaluatePosition(bitboard, isBlack);
+      Score score =
+          finalScore(bitboard.getScore(isBlack), bitboard.getScore(!isBlack));
       storeTTEntry(hash, score, depth, EntryType::EXACT, {-1, -1});
       return score;
     }
 
-    double score = -negamax(bitboard, depth - 1, -beta, -alpha, !isBlack,
-                            startTime, timeLimit, timeUp);
-    storeTTEntry(hash, score, depth, EntryType::EXACT, {-1, -1});
+    Score score =
+        -negamax(bitboard, depth - 1, -beta, -alpha, !isBlack, searchClock);
+    if (!searchClock.stopped()) {
+      storeTTEntry(hash, score, depth, boundOf(score, alphaOrig, beta),
+                   {-1, -1});
+    }
     return score;
   }
 
-  validMoves = orderMoves(bitboard, validMoves, isBlack, ttMove);
+  orderMoves(bitboard, validMoves, isBlack, ttMove);
 
-  double bestScore = -std::numeric_limits<double>::infinity();
+  Score bestScore = -SCORE_INFINITY;
   std::pair<int, int> bestMove = validMoves[0];
-  EntryType entryType = EntryType::UPPER_BOUND;
 
   int moveIndex = 0;
-  for (const auto &move : validMoves) {
-    if (timeUp)
+  for (int i = 0; i < validMoves.size(); ++i) {
+    const auto move = validMoves[i];
+    if (searchClock.stopped())
       break;
 
-    BitBoard tempBoard = bitboard;
-    if (tempBoard.makeMove(move.first, move.second, isBlack)) {
-      int nextDepth = depth - 1;
-      if (depth >= 3 && moveIndex >= 3 && !isCorner(move.first, move.second)) {
-        nextDepth -= 1;
+    int nextDepth = depth - 1;
+    if (depth >= 3 && moveIndex >= 3 && !isCorner(move.first, move.second)) {
+      nextDepth -= 1;
+    }
+    if (nextDepth < 0)
+      nextDepth = 0;
+
+    BitBoard::Undo undo;
+    bool legal;
+    Score score = 0;
+    if (copyMake) {
+      BitBoard child = bitboard;
+      legal = child.makeMove(validMoves.square(i), isBlack, undo);
+      if (legal)
+        score =
+            -negamax(child, nextDepth, -beta, -alpha, !isBlack, searchClock);
+    } else {
+      legal = bitboard.makeMove(validMoves.square(i), isBlack, undo);
+      if (legal) {
+        score =
+            -negamax(bitboard, nextDepth, -beta, -alpha, !isBlack, searchClock);
+        bitboard.unmakeMove(undo);
       }
-      if (nextDepth < 0)
-        nextDepth = 0;
-
-      double score = -negamax(tempBoard, nextDepth, -beta, -alpha, !isBlack,
-                              startTime, timeLimit, timeUp);
+    }
 
+    if (legal) {
       if (score > bestScore) {
         bestScore = score;
         bestMove = move;
       }
 
       alpha = std::max(alpha, score);
-      if (alpha >= beta) {
-        entryType = EntryType::LOWER_BOUND;
+      if (alpha >= beta)
         break;
-      }
     }
     moveIndex++;
   }
 
-  if (bestScore > alpha) {
-    entryType = EntryType::EXACT;
+  // Scores cut short by the clock would outlive this search in the table
+  if (searchClock.stopped()) {
+    return bestScore;
   }
-
-  storeTTEntry(hash, bestScore, depth, entryType, bestMove);
+  storeTTEntry(hash, bestScore, depth, boundOf(bestScore, alphaOrig, beta),
+               bestMove);
   return bestScore;
 }
 
-double PandaAIAgent::exactEndgameSearch(
-    BitBoard &bitboard, bool isBlack, int emptySquares,
-    std::chrono::steady_clock::time_point startTime,
-    std::chrono::milliseconds timeLimit, bool &timeUp) {
-  nodesSearched++;
-
-  if (nodesSearched % 128 == 0 && isTimeUp(startTime, timeLimit)) {
-    timeUp = true;
-    return 0.0;
+Score PandaAIAgent::exactEndgameSearch(BitBoard &bitboard, bool isBlack,
+                                       int emptySquares) {
+  if (clock.timeUp()) {
+    return 0;
   }
 
   if (bitboard.isGameOver()) {
-    int playerScore = bitboard.getScore(isBlack);
-    int opponentScore = bitboard.getScore(!isBlack);
-    double finalScore = static_cast<double>(playerScore - opponentScore);
-
-    if (finalScore > 0) {
-      finalScore += 100.0;
-    } else if (finalScore < 0) {
-      finalScore -= 100.0;
-    }
-
-    return finalScore;
+    return finalScore(bitboard.getScore(isBlack), bitboard.getScore(!isBlack));
   }
 
-  auto validMoves = bitboard.getValidMoves(isBlack);
+  MoveList validMoves;
+  bitboard.getValidMoves(isBlack, validMoves);
   if (validMoves.empty()) {
     if (!bitboard.hasValidMoves(!isBlack)) {
-      int playerScore = bitboard.getScore(isBlack);
-      int opponentScore = bitboard.getScore(!isBlack);
-      double finalScore = static_cast<double>(playerScore - opponentScore);
-
-      if (finalScore > 0) {
-        finalScore += 100.0;
-      } else if (finalScore < 0) {
-        finalScore -= 100.0;
-      }
-
-      return finalScore;
+      return finalScore(bitboard.getScore(isBlack),
+                        bitboard.getScore(!isBlack));
     }
 
-    return -exactEndgameSearch(bitboard, !isBlack, emptySquares, startTime,
-                               timeLimit, timeUp);
+    return -exactEndgameSearch(bitboard, !isBlack, emptySquares);
   }
 
-  double bestScore = -std::numeric_limits<double>::infinity();
+  Score bestScore = -SCORE_INFINITY;
 
-  for (const auto &move : validMoves) {
-    if (timeUp)
+  for (int i = 0; i < validMoves.size(); ++i) {
+    if (clock.stopped())
       break;
 
-    BitBoard tempBoard = bitboard;
-    if (tempBoard.makeMove(move.first, move.second, isBlack)) {
-      double score = -exactEndgameSearch(tempBoard, !isBlack, emptySquares - 1,
-                                         startTime, timeLimit, timeUp);
+    BitBoard::Undo undo;
+    if (bitboard.makeMove(validMoves.square(i), isBlack, undo)) {
+      Score score = -exactEndgameSearch(bitboard, !isBlack, emptySquares - 1);
+      bitboard.unmakeMove(undo);
       bestScore = std::max(bestScore, score);
     }
   }
@@ -372,9 +460,9 @@ double PandaAIAgent::exactEndgameSearch(
   return bestScore;
 }
 
-inline double PandaAIAgent::evaluatePosition(const BitBoard &bitboard,
-                                             bool isBlack) const {
-  double score = 0.0;
+inline Score PandaAIAgent::evaluatePosition(const BitBoard &bitboard,
+                                            bool isBlack) const {
+  Score score = 0;
 
   uint64_t playerBoard = bitboard.getPlayerBoard(isBlack);
   uint64_t opponentBoard = bitboard.getPlayerBoard(!isBlack);
@@ -383,31 +471,30 @@ inline double PandaAIAgent::evaluatePosition(const BitBoard &bitboard,
   uint64_t corners = bitboard.getCornerMask();
   int playerCorners = __builtin_popcountll(playerBoard & corners);
   int opponentCorners = __builtin_popcountll(opponentBoard & corners);
-  score += (playerCorners - opponentCorners) * 25.0;
+  score += (playerCorners - opponentCorners) * 25 * SCORE_SCALE;
 
   uint64_t edges = bitboard.getEdgeMask();
   int playerEdges = __builtin_popcountll(playerBoard & edges);
   int opponentEdges = __builtin_popcountll(opponentBoard & edges);
-  score += (playerEdges - opponentEdges) * 5.0;
+  score += (playerEdges - opponentEdges) * 5 * SCORE_SCALE;
 
-  int playerMoves = bitboard.getValidMoves(isBlack).size();
-  int opponentMoves = bitboard.getValidMoves(!isBlack).size();
+  int playerMoves = __builtin_popcountll(bitboard.legalMovesMask(isBlack));
+  int opponentMoves = __builtin_popcountll(bitboard.legalMovesMask(!isBlack));
   if (playerMoves + opponentMoves > 0) {
-    score += ((double)(playerMoves - opponentMoves) /
-              (playerMoves + opponentMoves)) *
-             15.0;
+    score += (playerMoves - opponentMoves) * 15 * SCORE_SCALE /
+             (playerMoves + opponentMoves);
   }
 
   int playerDiscs = bitboard.getScore(isBlack);
   int opponentDiscs = bitboard.getScore(!isBlack);
-  score += ((double)(playerDiscs - opponentDiscs) / totalDiscs) * 5.0;
+  score += (playerDiscs - opponentDiscs) * 5 * SCORE_SCALE / totalDiscs;
 
   uint64_t stableMask = bitboard.getStableMask();
   uint64_t playerStable = playerBoard & stableMask;
   uint64_t opponentStable = opponentBoard & stableMask;
   int playerStableCount = __builtin_popcountll(playerStable);
   int opponentStableCount = __builtin_popcountll(opponentStable);
-  score += (playerStableCount - opponentStableCount) * 10.0;
+  score += (playerStableCount - opponentStableCount) * 10 * SCORE_SCALE;
 
   const auto &table = (totalDiscs < 20)   ? OPENING_VALUES
                       : (totalDiscs > 50) ? ENDGAME_VALUES
@@ -416,9 +503,9 @@ inline double PandaAIAgent::evaluatePosition(const BitBoard &bitboard,
     for (int c = 0; c < 8; ++c) {
       int cell = bitboard.getCell(r, c);
       if (cell == (isBlack ? 1 : 2)) {
-        score += table[r][c];
+        score += table[r][c] * SCORE_SCALE;
       } else if (cell == (isBlack ? 2 : 1)) {
-        score -= table[r][c];
+        score -= table[r][c] * SCORE_SCALE;
       }
     }
   }
@@ -430,29 +517,29 @@ PandaAIAgent::EvaluationWeights
 PandaAIAgent::getWeights(GamePhase phase) const {
   switch (phase) {
   case GamePhase::OPENING:
-    return {20.0, 100.0, 10.0, 15.0, 1.0, 8.0};
+    return {20, 100, 10, 15, 1, 8};
   case GamePhase::MIDGAME:
-    return {15.0, 80.0, 20.0, 25.0, 5.0, 10.0};
+    return {15, 80, 20, 25, 5, 10};
   case GamePhase::ENDGAME:
-    return {10.0, 50.0, 15.0, 20.0, 30.0, 5.0};
+    return {10, 50, 15, 20, 30, 5};
   }
-  return {15.0, 80.0, 20.0, 25.0, 5.0, 10.0};
+  return {15, 80, 20, 25, 5, 10};
 }
 
-double PandaAIAgent::evaluateMobility(const BitBoard &bitboard,
-                                      bool isBlack) const {
-  int playerMoves = bitboard.getValidMoves(isBlack).size();
-  int opponentMoves = bitboard.getValidMoves(!isBlack).size();
+Score PandaAIAgent::evaluateMobility(const BitBoard &bitboard,
+                                     bool isBlack) const {
+  int playerMoves = __builtin_popcountll(bitboard.legalMovesMask(isBlack));
+  int opponentMoves = __builtin_popcountll(bitboard.legalMovesMask(!isBlack));
 
   if (playerMoves + opponentMoves == 0)
-    return 0.0;
+    return 0;
 
-  return static_cast<double>(playerMoves - opponentMoves) /
+  return (playerMoves - opponentMoves) * SCORE_SCALE /
          (playerMoves + opponentMoves);
 }
 
-double PandaAIAgent::evaluateCornerControl(const BitBoard &bitboard,
-                                           bool isBlack) const {
+Score PandaAIAgent::evaluateCornerControl(const BitBoard &bitboard,
+                                          bool isBlack) const {
   uint64_t corners = bitboard.getCornerMask();
   uint64_t playerBoard = bitboard.getPlayerBoard(isBlack);
   uint64_t opponentBoard = bitboard.getPlayerBoard(!isBlack);
@@ -460,11 +547,11 @@ double PandaAIAgent::evaluateCornerControl(const BitBoard &bitboard,
   int playerCorners = __builtin_popcountll(playerBoard & corners);
   int opponentCorners = __builtin_popcountll(opponentBoard & corners);
 
-  return static_cast<double>(playerCorners - opponentCorners);
+  return (playerCorners - opponentCorners) * SCORE_SCALE;
 }
 
-double PandaAIAgent::evaluateEdgeControl(const BitBoard &bitboard,
-                                         bool isBlack) const {
+Score PandaAIAgent::evaluateEdgeControl(const BitBoard &bitboard,
+                                        bool isBlack) const {
   uint64_t edges = bitboard.getEdgeMask();
   uint64_t playerBoard = bitboard.getPlayerBoard(isBlack);
   uint64_t opponentBoard = bitboard.getPlayerBoard(!isBlack);
@@ -472,17 +559,17 @@ double PandaAIAgent::evaluateEdgeControl(const BitBoard &bitboard,
   int playerEdges = __builtin_popcountll(playerBoard & edges);
   int opponentEdges = __builtin_popcountll(opponentBoard & edges);
 
-  return static_cast<double>(playerEdges - opponentEdges);
+  return (playerEdges - opponentEdges) * SCORE_SCALE;
 }
 
-double PandaAIAgent::evaluateStability(const BitBoard &bitboard,
-                                       bool isBlack) const {
-  double stability = 0.0;
+Score PandaAIAgent::evaluateStability(const BitBoard &bitboard,
+                                      bool isBlack) const {
+  Score stability = 0;
 
   uint64_t playerBoard = bitboard.getPlayerBoard(isBlack);
   uint64_t corners = bitboard.getCornerMask();
 
-  stability += __builtin_popcountll(playerBoard & corners) * 10.0;
+  stability += __builtin_popcountll(playerBoard & corners) * 10 * SCORE_SCALE;
 
   uint64_t stableEdges = 0;
   if (playerBoard & (1ULL << 0))
@@ -494,31 +581,32 @@ double PandaAIAgent::evaluateStability(const BitBoard &bitboard,
   if (playerBoard & (1ULL << 63))
     stableEdges |= (1ULL << 55) | (1ULL << 62);
 
-  stability += __builtin_popcountll(playerBoard & stableEdges) * 3.0;
+  stability +=
+      __builtin_popcountll(playerBoard & stableEdges) * 3 * SCORE_SCALE;
 
   return stability;
 }
 
-double PandaAIAgent::evaluateDiscCount(const BitBoard &bitboard,
-                                       bool isBlack) const {
+Score PandaAIAgent::evaluateDiscCount(const BitBoard &bitboard,
+                                      bool isBlack) const {
   int playerDiscs = bitboard.getScore(isBlack);
   int opponentDiscs = bitboard.getScore(!isBlack);
   int totalDiscs = bitboard.getTotalDiscs();
 
   if (totalDiscs == 0)
-    return 0.0;
+    return 0;
 
-  return static_cast<double>(playerDiscs - opponentDiscs) / totalDiscs;
+  return (playerDiscs - opponentDiscs) * SCORE_SCALE / totalDiscs;
 }
 
-double PandaAIAgent::evaluatePositional(const BitBoard &bitboard,
-                                        bool isBlack) const {
+Score PandaAIAgent::evaluatePositional(const BitBoard &bitboard,
+                                       bool isBlack) const {
   GamePhase phase = getGamePhase(bitboard);
   const auto &table = (phase == GamePhase::OPENING)   ? OPENING_VALUES
                       : (phase == GamePhase::ENDGAME) ? ENDGAME_VALUES
                                                       : POSITION_VALUES;
 
-  double score = 0.0;
+  Score score = 0;
   uint64_t playerBoard = bitboard.getPlayerBoard(isBlack);
   uint64_t opponentBoard = bitboard.getPlayerBoard(!isBlack);
 
@@ -526,9 +614,9 @@ double PandaAIAgent::evaluatePositional(const BitBoard &bitboard,
     for (int col = 0; col < 8; ++col) {
       uint64_t mask = BitBoard::positionToMask(row, col);
       if (playerBoard & mask) {
-        score += table[row][col];
+        score += table[row][col] * SCORE_SCALE;
       } else if (opponentBoard & mask) {
-        score -= table[row][col];
+        score -= table[row][col] * SCORE_SCALE;
       }
     }
   }
@@ -536,19 +624,19 @@ double PandaAIAgent::evaluatePositional(const BitBoard &bitboard,
   return score;
 }
 
-bool PandaAIAgent::probeTTEntry(uint64_t hash, int depth, double alpha,
-                                double beta, double &score,
+bool PandaAIAgent::probeTTEntry(uint64_t hash, int depth, Score alpha,
+                                Score beta, Score &score,
                                 std::pair<int, int> &bestMove) const {
-  size_t index = hash % TT_SIZE;
-  const TTEntry &entry = transpositionTable[index];
-
-  if (entry.hash != hash || entry.depth < depth) {
+  TranspositionTable::Entry entry;
+  if (!transpositionTable.probe(hash, entry) || entry.depth < depth) {
     return false;
   }
 
-  bestMove = entry.bestMove;
+  bestMove = entry.move == TranspositionTable::NO_MOVE
+                 ? std::make_pair(-1, -1)
+                 : std::make_pair(entry.move / 8, entry.move % 8);
 
-  switch (entry.type) {
+  switch (entry.bound) {
   case EntryType::EXACT:
     score = entry.score;
     return true;
@@ -569,58 +657,31 @@ bool PandaAIAgent::probeTTEntry(uint64_t hash, int depth, double alpha,
   return false;
 }
 
-void PandaAIAgent::storeTTEntry(uint64_t hash, double score, int depth,
+void PandaAIAgent::storeTTEntry(uint64_t hash, Score score, int depth,
                                 EntryType type,
                                 std::pair<int, int> bestMove) const {
-  size_t index = hash % TT_SIZE;
-  TTEntry &e = transpositionTable[index];
-
-  bool replace = false;
-
-  if (e.hash == 0) {
-    replace = true;
-  } else if (e.hash == hash) {
-    if (depth >= e.depth || type == EntryType::EXACT ||
-        e.type != EntryType::EXACT) {
-      replace = true;
-    }
-  } else {
-    if (depth > e.depth) {
-      replace = true;
-    }
-  }
-
-  if (replace) {
-    e.hash = hash;
-    e.score = score;
-    e.depth = depth;
-    e.type = type;
-    e.bestMove = bestMove;
-  }
+  transpositionTable.store(hash, score, depth, type,
+                           bestMove.first < 0
+                               ? TranspositionTable::NO_MOVE
+                               : bestMove.first * 8 + bestMove.second);
 }
 
-std::vector<std::pair<int, int>>
-PandaAIAgent::orderMoves(const BitBoard &bitboard,
-                         const std::vector<std::pair<int, int>> &moves,
-                         bool isBlack, std::pair<int, int> ttMove) const {
-
-  std::vector<std::pair<std::pair<int, int>, double>> scoredMoves;
-  scoredMoves.reserve(moves.size());
+void PandaAIAgent::orderMoves(const BitBoard &bitboard, MoveList &moves,
+                              bool isBlack, std::pair<int, int> ttMove) const {
+  const uint64_t player = bitboard.getPlayerBoard(isBlack);
+  const uint64_t opponent = bitboard.getOpponentBoard(isBlack);
+  const bool opening = (bitboard.getTotalDiscs() <= 20);
 
-  for (const auto &move : moves) {
-    double score = 0.0;
+  for (int i = 0; i < moves.size(); ++i) {
+    const auto move = moves[i];
+    int score = 0;
 
     if (move == ttMove) {
-      score += 10000.0;
-    }
-
-    int hidx = move.first * 8 + move.second;
-    if (hidx >= 0 && hidx < 64) {
-      // history disabled in snapshot
+      score += 10000;
     }
 
     if (isCorner(move.first, move.second)) {
-      score += 1000.0;
+      score += 1000;
     }
 
     bool adjacentToEmptyCorner = false;
@@ -637,53 +698,37 @@ PandaAIAgent::orderMoves(const BitBoard &bitboard,
     }
 
     if (adjacentToEmptyCorner) {
-      score -= 500.0;
+      score -= 500;
     }
 
     int row = move.first, col = move.second;
-    int totalDiscs = bitboard.getTotalDiscs();
-    bool opening = (totalDiscs <= 20);
-
     if (row == 0 || row == 7 || col == 0 || col == 7) {
-      score += opening ? 20.0 : 100.0;
+      score += opening ? 20 : 100;
     }
 
-    BitBoard temp = bitboard;
-    int beforeScore = bitboard.getScore(isBlack);
-    if (temp.makeMove(row, col, isBlack)) {
-      int afterScore = temp.getScore(isBlack);
-      int flips = afterScore - beforeScore - 1;
-      double flipWeight = opening ? 2.0 : 10.0;
-      score += flips * flipWeight;
-    }
+    uint64_t flips = BitBoard::flipsMask(moves.square(i), player, opponent);
+    transpositionTable.prefetch(bitboard.getZobristHashAfter(
+        moves.square(i), flips, isBlack, !isBlack));
+    score += __builtin_popcountll(flips) * (opening ? 2 : 10);
 
-    BitBoard tmp2 = bitboard;
-    if (tmp2.makeMove(row, col, isBlack)) {
-      int myMob = tmp2.getValidMoves(isBlack).size();
-      int oppMob = tmp2.getValidMoves(!isBlack).size();
-      double mobWeight = opening ? 8.0 : 5.0;
-      score += (myMob - oppMob) * mobWeight;
-    }
+    uint64_t myAfter = player | flips | (1ULL << moves.square(i));
+    uint64_t oppAfter = opponent ^ flips;
+    int myMob =
+        __builtin_popcountll(BitBoard::legalMovesMask(myAfter, oppAfter));
+    int oppMob =
+        __builtin_popcountll(BitBoard::legalMovesMask(oppAfter, myAfter));
+    score += (myMob - oppMob) * (opening ? 8 : 5);
 
-    scoredMoves.emplace_back(move, score);
+    moves.setScore(i, score);
   }
 
-  std::sort(scoredMoves.begin(), scoredMoves.end(),
-            [](const auto &a, const auto &b) { return a.second > b.second; });
-
-  std::vector<std::pair<int, int>> orderedMoves;
-  orderedMoves.reserve(moves.size());
-  for (const auto &scoredMove : scoredMoves) {
-    orderedMoves.push_back(scoredMove.first);
-  }
-
-  return orderedMoves;
+  moves.sortByScore();
 }
 
-double PandaAIAgent::scoreMoveForOrdering(const BitBoard &bitboard,
-                                          std::pair<int, int> move,
-                                          bool isBlack) const {
-  double score = 0.0;
+int PandaAIAgent::scoreMoveForOrdering(const BitBoard &bitboard,
+                                       std::pair<int, int> move,
+                                       bool isBlack) const {
+  int score = 0;
 
   BitBoard tempBoard = bitboard;
   int beforeScore = tempBoard.getScore(isBlack);
@@ -694,16 +739,18 @@ double PandaAIAgent::scoreMoveForOrdering(const BitBoard &bitboard,
     int afterScore = tempBoard.getScore(isBlack);
     int flippedDiscs = afterScore - beforeScore - 1;
 
-    double flipW = (phase == GamePhase::OPENING) ? 2.0 : 10.0;
+    int flipW = (phase == GamePhase::OPENING) ? 2 : 10;
     score += flippedDiscs * flipW;
 
-    int playerMobility = tempBoard.getValidMoves(isBlack).size();
-    int opponentMobility = tempBoard.getValidMoves(!isBlack).size();
-    double mobW = (phase == GamePhase::OPENING) ? 8.0 : 5.0;
+    int playerMobility =
+        __builtin_popcountll(tempBoard.legalMovesMask(isBlack));
+    int opponentMobility =
+        __builtin_popcountll(tempBoard.legalMovesMask(!isBlack));
+    int mobW = (phase == GamePhase::OPENING) ? 8 : 5;
     score += (playerMobility - opponentMobility) * mobW;
 
     if (phase != GamePhase::OPENING && isEdge(move.first, move.second)) {
-      score += 20.0;
+      score += 20;
     }
   }
 
@@ -712,7 +759,8 @@ double PandaAIAgent::scoreMoveForOrdering(const BitBoard &bitboard,
 
 std::pair<int, int> PandaAIAgent::getOpeningMove(const BitBoard &bitboard,
                                                  bool isBlack) const {
-  auto validMoves = bitboard.getValidMoves(isBlack);
+  MoveList validMoves;
+  bitboard.getValidMoves(isBlack, validMoves);
   if (validMoves.empty())
     return {-1, -1};
 
@@ -726,18 +774,20 @@ bool PandaAIAgent::isOpeningPosition(const BitBoard &bitboard) const {
   return bitboard.getTotalDiscs() <= 20;
 }
 
-std::pair<int, int> PandaAIAgent::selectStrategicOpeningMove(
-    const BitBoard &bitboard,
-    const std::vector<std::pair<int, int>> &validMoves, bool isBlack) const {
+std::pair<int, int>
+PandaAIAgent::selectStrategicOpeningMove(const BitBoard &bitboard,
+                                         const MoveList &validMoves,
+                                         bool isBlack) const {
 
   std::pair<int, int> bestMove = validMoves[0];
-  double bestScore = -std::numeric_limits<double>::infinity();
+  int bestScore = std::numeric_limits<int>::min();
 
-  for (const auto &move : validMoves) {
-    double score = 0.0;
+  for (int i = 0; i < validMoves.size(); ++i) {
+    const auto move = validMoves[i];
+    int score = 0;
 
     if (isCorner(move.first, move.second))
-      score += 1000.0;
+      score += 1000;
 
     bool adjacentToEmptyCorner = false;
     for (int dr = -1; dr <= 1; ++dr) {
@@ -752,16 +802,16 @@ std::pair<int, int> PandaAIAgent::selectStrategicOpeningMove(
         break;
     }
     if (adjacentToEmptyCorner)
-      score -= 500.0;
+      score -= 500;
 
     BitBoard temp = bitboard;
     if (temp.makeMove(move.first, move.second, isBlack)) {
-      int myMob = temp.getValidMoves(isBlack).size();
-      int oppMob = temp.getValidMoves(!isBlack).size();
-      score += (myMob - oppMob) * 10.0;
+      int myMob = __builtin_popcountll(temp.legalMovesMask(isBlack));
+      int oppMob = __builtin_popcountll(temp.legalMovesMask(!isBlack));
+      score += (myMob - oppMob) * 10;
 
       int flips = temp.getScore(isBlack) - bitboard.getScore(isBlack) - 1;
-      score += flips * 2.0;
+      score += flips * 2;
     }
 
     if (score > bestScore) {
@@ -774,3 +824,20 @@ std::pair<int, int> PandaAIAgent::selectStrategicOpeningMove(
 }
 
 REGISTER_AI_AGENT(PandaAIAgent, "panda");
+
+namespace {
+// Lazy SMP on every core, for hosts that play one game at a time
+class PandaSmpFactory {
+public:
+  PandaSmpFactory() {
+    registerAIAgent("panda_smp", [](const std::string &name,
+                                    const std::string &author)
+                                     -> std::unique_ptr<AIAgentBase> {
+      int cores = static_cast<int>(std::thread::hardware_concurrency());
+      return std::make_unique<PandaAIAgent>(name, author, 12,
+                                            std::max(1, cores));
+    });
+  }
+};
+static PandaSmpFactory PandaSmpFactoryInstance;
+} // namespace
@@ -34,36 +34,26 @@ PlagiatBot::PlagiatBot(const std::string &name, const std::string &author,
 inline std::pair<int, int>
 PlagiatBot::getBestMove(const Board &board, CellState player,
                         std::chrono::milliseconds timeLimit) {
-  timeLimit = std::chrono::duration_cast<std::chrono::milliseconds>(
-      timeLimit * 95 / 100); // make sure to avoid time outs
-  auto startTime = std::chrono::steady_clock::now();
-  BitBoard bitboard;
-  for (int row = 0; row < 8; ++row) {
-    for (int col = 0; col < 8; ++col) {
-      CellState cell = board.getCell(row, col);
-      if (cell == CellState::BLACK) {
-        bitboard.setCell(row, col, 1);
-      } else if (cell == CellState::WHITE) {
-        bitboard.setCell(row, col, 2);
-      }
-    }
-  }
+  clock.start(timeLimit * 95 / 100); // make sure to avoid time outs
+  transpositionTable.newSearch();
+  BitBoard bitboard = getBitBoard(board);
   bool isBlackTurn = (player == CellState::BLACK);
-  auto moves = bitboard.getValidMoves(isBlackTurn);
+  MoveList moves;
+  bitboard.getValidMoves(isBlackTurn, moves);
   if (moves.empty())
     return {-1, -1};
-  moves = orderMoves(bitboard, moves, isBlackTurn);
-  std::pair<int, int> bestMove = moves.front();
-  double bestScore = std::numeric_limits<double>::lowest();
-  for (const auto &mv : moves) {
-    if (isTimeUp(startTime, timeLimit))
+  orderMoves(bitboard, moves, isBlackTurn);
+  std::pair<int, int> bestMove = moves[0];
+  Score bestScore = -SCORE_INFINITY;
+  for (int i = 0; i < moves.size(); ++i) {
+    const auto mv = moves[i];
+    if (clock.hardTimeUp())
       break;
-    BitBoard temp = bitboard;
-    if (temp.makeMove(mv.first, mv.second, isBlackTurn)) {
-      double score = bitboardMinMax(temp, maxDepth - 1,
-                                    std::numeric_limits<double>::lowest(),
-                                    std::numeric_limits<double>::max(),
-                                    isBlackTurn, false, startTime, timeLimit);
+    BitBoard::Undo undo;
+    if (bitboard.makeMove(moves.square(i), isBlackTurn, undo)) {
+      Score score = bitboardMinMax(bitboard, maxDepth - 1, -SCORE_INFINITY,
+                                   SCORE_INFINITY, isBlackTurn, false);
+      bitboard.unmakeMove(undo);
       if (score > bestScore) {
         bestScore = score;
         bestMove = mv;
@@ -73,18 +63,20 @@ PlagiatBot::getBestMove(const Board &board, CellState player,
   return bestMove;
 }
 
-inline double
-PlagiatBot::bitboardMinMax(BitBoard &bitboard, int depth, double alpha,
-                           double beta, bool isBlack, bool isMaximizing,
-                           std::chrono::steady_clock::time_point startTime,
-                           std::chrono::milliseconds timeLimit) {
-  if (isTimeUp(startTime, timeLimit))
-    return 0.0;
-  uint64_t hash = getZobristHash(bitboard);
-  auto it = transpositionTable.find(hash);
-  if (it != transpositionTable.end() && it->second.depth >= depth) {
-    const auto &entry = it->second;
-    switch (entry.type) {
+void PlagiatBot::onGameStart() { transpositionTable.newGame(); }
+
+inline Score
+PlagiatBot::bitboardMinMax(BitBoard &bitboard, int depth, Score alpha,
+                           Score beta, bool isBlack, bool isMaximizing) {
+  if (clock.timeUp())
+    return 0;
+  const Score alphaOrig = alpha;
+  const Score betaOrig = beta;
+  uint64_t hash = getZobristHash(bitboard, isMaximizing ? isBlack : !isBlack) ^
+                  (isBlack ? BLACK_ROOT_KEY : 0);
+  TranspositionTable::Entry entry;
+  if (transpositionTable.probe(hash, entry) && entry.depth >= depth) {
+    switch (entry.bound) {
     case EntryType::EXACT:
       return entry.score;
     case EntryType::LOWER_BOUND:
@@ -97,94 +89,86 @@ PlagiatBot::bitboardMinMax(BitBoard &bitboard, int depth, double alpha,
       break;
     }
   }
-  if (depth == 0 || bitboard.isGameOver()) {
-    double sc = evaluateBitboard(bitboard, isBlack);
-    if (transpositionTable.size() < MAX_TRANSPOSITION_SIZE) {
-      transpositionTable[hash] =
-          TranspositionEntry(hash, sc, depth, EntryType::EXACT);
-    }
+  if (bitboard.isGameOver()) {
+    Score sc =
+        finalScore(bitboard.getScore(isBlack), bitboard.getScore(!isBlack));
+    ttStore(hash, sc, depth, EntryType::EXACT);
     return sc;
   }
-  auto moves = bitboard.getValidMoves(isMaximizing ? isBlack : !isBlack);
+  if (depth == 0) {
+    Score sc = evaluateBitboard(bitboard, isBlack);
+    ttStore(hash, sc, depth, EntryType::EXACT);
+    return sc;
+  }
+  MoveList moves;
+  bitboard.getValidMoves(isMaximizing ? isBlack : !isBlack, moves);
   if (moves.empty()) {
-    double sc = bitboardMinMax(bitboard, depth - 1, alpha, beta, isBlack,
-                               !isMaximizing, startTime, timeLimit);
+    Score sc = bitboardMinMax(bitboard, depth - 1, alpha, beta, isBlack,
+                              !isMaximizing);
     return sc;
   }
-  moves = orderMoves(bitboard, moves, isMaximizing ? isBlack : !isBlack);
+  orderMoves(bitboard, moves, isMaximizing ? isBlack : !isBlack);
+  Score best = isMaximizing ? -SCORE_INFINITY : SCORE_INFINITY;
+  bool cutoff = false;
   if (isMaximizing) {
-    double best = std::numeric_limits<double>::lowest();
-    EntryType eType = EntryType::UPPER_BOUND;
-    for (const auto &mv : moves) {
-      if (isTimeUp(startTime, timeLimit))
+    for (int i = 0; i < moves.size(); ++i) {
+      if (clock.timeUp())
         break;
-      BitBoard temp = bitboard;
-      if (temp.makeMove(mv.first, mv.second, isBlack)) {
-        double sc = bitboardMinMax(temp, depth - 1, alpha, beta, isBlack, false,
-                                   startTime, timeLimit);
+      BitBoard::Undo undo;
+      if (bitboard.makeMove(moves.square(i), isBlack, undo)) {
+        Score sc =
+            bitboardMinMax(bitboard, depth - 1, alpha, beta, isBlack, false);
+        bitboard.unmakeMove(undo);
         best = std::max(best, sc);
         alpha = std::max(alpha, sc);
         if (beta <= alpha) {
-          if (transpositionTable.size() < MAX_TRANSPOSITION_SIZE) {
-            transpositionTable[hash] =
-                TranspositionEntry(hash, best, depth, EntryType::UPPER_BOUND);
-          }
+          cutoff = true;
           break;
         }
       }
     }
-    if (best <= alpha)
-      eType = EntryType::UPPER_BOUND;
-    else if (best >= beta)
-      eType = EntryType::LOWER_BOUND;
-    else
-      eType = EntryType::EXACT;
-    if (transpositionTable.size() < MAX_TRANSPOSITION_SIZE) {
-      transpositionTable[hash] = TranspositionEntry(hash, best, depth, eType);
-    }
-    return best;
   } else {
-    double best = std::numeric_limits<double>::max();
-    EntryType eType = EntryType::LOWER_BOUND;
-    for (const auto &mv : moves) {
-      if (isTimeUp(startTime, timeLimit))
+    for (int i = 0; i < moves.size(); ++i) {
+      if (clock.timeUp())
         break;
-      BitBoard temp = bitboard;
-      if (temp.makeMove(mv.first, mv.second, !isBlack)) {
-        double sc = bitboardMinMax(temp, depth - 1, alpha, beta, isBlack, true,
-                                   startTime, timeLimit);
+      BitBoard::Undo undo;
+      if (bitboard.makeMove(moves.square(i), !isBlack, undo)) {
+        Score sc =
+            bitboardMinMax(bitboard, depth - 1, alpha, beta, isBlack, true);
+        bitboard.unmakeMove(undo);
         best = std::min(best, sc);
         beta = std::min(beta, sc);
         if (beta <= alpha) {
-          if (transpositionTable.size() < MAX_TRANSPOSITION_SIZE) {
-            transpositionTable[hash] =
-                TranspositionEntry(hash, best, depth, EntryType::LOWER_BOUND);
-          }
+          cutoff = true;
           break;
         }
       }
     }
-    if (best <= alpha)
-      eType = EntryType::UPPER_BOUND;
-    else if (best >= beta)
-      eType = EntryType::LOWER_BOUND;
-    else
-      eType = EntryType::EXACT;
-    if (transpositionTable.size() < MAX_TRANSPOSITION_SIZE) {
-      transpositionTable[hash] = TranspositionEntry(hash, best, depth, eType);
-    }
-    return best;
   }
+
+  // Classified against the window this node was called with, not the one
+  // its children narrowed
+  EntryType eType;
+  if (cutoff)
+    eType = isMaximizing ? EntryType::LOWER_BOUND : EntryType::UPPER_BOUND;
+  else if (best <= alphaOrig)
+    eType = EntryType::UPPER_BOUND;
+  else if (best >= betaOrig)
+    eType = EntryType::LOWER_BOUND;
+  else
+    eType = EntryType::EXACT;
+  ttStore(hash, best, depth, eType);
+  return best;
 }
 
-inline double PlagiatBot::evaluateBitboard(const BitBoard &bitboard,
-                                           bool isBlack) const {
-  double sc = 0.0;
-  sc += evaluateCornerControlBitboard(bitboard, isBlack) * 25.0;
-  sc += evaluateEdgeControlBitboard(bitboard, isBlack) * 5.0;
-  sc += evaluateMobilityBitboard(bitboard, isBlack) * 15.0;
-  sc += evaluateDiscCountBitboard(bitboard, isBlack) * 5.0;
-  sc += evaluateStabilityBitboard(bitboard, isBlack) * 15.0;
+inline Score PlagiatBot::evaluateBitboard(const BitBoard &bitboard,
+                                          bool isBlack) const {
+  Score sc = 0;
+  sc += evaluateCornerControlBitboard(bitboard, isBlack) * 25;
+  sc += evaluateEdgeControlBitboard(bitboard, isBlack) * 5;
+  sc += evaluateMobilityBitboard(bitboard, isBlack) * 15;
+  sc += evaluateDiscCountBitboard(bitboard, isBlack) * 5;
+  sc += evaluateStabilityBitboard(bitboard, isBlack) * 15;
   int discs = bitboard.getTotalDiscs();
   const auto &table = (discs < 20)   ? EARLY_GAME_VALUES
                       : (discs > 50) ? LATE_GAME_VALUES
@@ -193,45 +177,45 @@ inline double PlagiatBot::evaluateBitboard(const BitBoard &bitboard,
     for (int c = 0; c < 8; ++c) {
       int st = bitboard.getCell(r, c);
       if (st == (isBlack ? 1 : 2))
-        sc += table[r][c];
+        sc += table[r][c] * SCORE_SCALE;
       else if (st == (isBlack ? 2 : 1))
-        sc -= table[r][c];
+        sc -= table[r][c] * SCORE_SCALE;
     }
   }
   return sc;
 }
 
-inline double PlagiatBot::evaluateCornerControlBitboard(const BitBoard &bb,
-                                                        bool isBlack) const {
+inline Score PlagiatBot::evaluateCornerControlBitboard(const BitBoard &bb,
+                                                       bool isBlack) const {
   uint64_t corners = bb.getCornerMask();
   uint64_t player = bb.getPlayerBoard(isBlack);
   uint64_t opponent = bb.getOpponentBoard(isBlack);
   int pc = __builtin_popcountll(player & corners);
   int oc = __builtin_popcountll(opponent & corners);
-  return static_cast<double>(pc - oc);
+  return (pc - oc) * SCORE_SCALE;
 }
 
-inline double PlagiatBot::evaluateEdgeControlBitboard(const BitBoard &bb,
-                                                      bool isBlack) const {
+inline Score PlagiatBot::evaluateEdgeControlBitboard(const BitBoard &bb,
+                                                     bool isBlack) const {
   uint64_t edges = bb.getEdgeMask();
   uint64_t player = bb.getPlayerBoard(isBlack);
   uint64_t opponent = bb.getOpponentBoard(isBlack);
   int pe = __builtin_popcountll(player & edges);
   int oe = __builtin_popcountll(opponent & edges);
-  return static_cast<double>(pe - oe);
+  return (pe - oe) * SCORE_SCALE;
 }
 
-inline double PlagiatBot::evaluateMobilityBitboard(const BitBoard &bb,
-                                                   bool isBlack) const {
-  int pMoves = bb.getValidMoves(isBlack).size();
-  int oMoves = bb.getValidMoves(!isBlack).size();
+inline Score PlagiatBot::evaluateMobilityBitboard(const BitBoard &bb,
+                                                  bool isBlack) const {
+  int pMoves = __builtin_popcountll(bb.legalMovesMask(isBlack));
+  int oMoves = __builtin_popcountll(bb.legalMovesMask(!isBlack));
   if (pMoves + oMoves == 0)
-    return 0.0;
-  return static_cast<double>(pMoves - oMoves) / (pMoves + oMoves);
+    return 0;
+  return (pMoves - oMoves) * SCORE_SCALE / (pMoves + oMoves);
 }
 
-inline double PlagiatBot::evaluateStabilityBitboard(const BitBoard &bb,
-                                                    bool isBlack) const {
+inline Score PlagiatBot::evaluateStabilityBitboard(const BitBoard &bb,
+                                                   bool isBlack) const {
   auto computeStable = [&](uint64_t playerBoard) {
     uint64_t stable = 0ULL;
 
@@ -328,29 +312,33 @@ inline double PlagiatBot::evaluateStabilityBitboard(const BitBoard &bb,
   int pCount = __builtin_popcountll(playerStable);
   int oCount = __builtin_popcountll(opponentStable);
 
-  return static_cast<double>(pCount - oCount);
+  return (pCount - oCount) * SCORE_SCALE;
 }
 
-inline double PlagiatBot::evaluateDiscCountBitboard(const BitBoard &bb,
-                                                    bool isBlack) const {
+inline Score PlagiatBot::evaluateDiscCountBitboard(const BitBoard &bb,
+                                                   bool isBlack) const {
   int p = bb.getScore(isBlack);
   int o = bb.getScore(!isBlack);
   int t = bb.getTotalDiscs();
   if (t == 0)
-    return 0.0;
-  return static_cast<double>(p - o) / t;
+    return 0;
+  return (p - o) * SCORE_SCALE / t;
 }
 
-inline uint64_t PlagiatBot::getZobristHash(const BitBoard &bb) const {
-  return bb.getZobristHash();
+inline uint64_t PlagiatBot::getZobristHash(const BitBoard &bb,
+                                           bool blackToMove) const {
+  return bb.getZobristHash(blackToMove);
 }
 
-inline void PlagiatBot::clearTranspositionTable() {
-  transpositionTable.clear();
+void PlagiatBot::ttStore(uint64_t hash, Score score, int depth,
+                         EntryType type) {
+  if (!clock.stopped()) {
+    transpositionTable.store(hash, score, depth, type);
+  }
 }
 
 inline size_t PlagiatBot::getTranspositionTableSize() const {
-  return transpositionTable.size();
+  return transpositionTable.entries();
 }
 
 inline bool PlagiatBot::isBlackPlayer(CellState p) const {
@@ -361,39 +349,24 @@ inline CellState PlagiatBot::playerFromBool(bool isBlack) const {
   return isBlack ? CellState::BLACK : CellState::WHITE;
 }
 
-inline std::vector<std::pair<int, int>>
-PlagiatBot::orderMoves(const BitBoard &bb,
-                       const std::vector<std::pair<int, int>> &moves,
-                       bool isBlack) const {
-  std::vector<std::pair<std::pair<int, int>, double>> moveScores;
-  for (const auto &mv : moves) {
-    double score = 0.0;
+inline void PlagiatBot::orderMoves(const BitBoard &bb, MoveList &moves,
+                                   bool isBlack) const {
+  for (int i = 0; i < moves.size(); ++i) {
+    const auto mv = moves[i];
+    int score = 0;
     if ((mv.first == 0 || mv.first == 7) && (mv.second == 0 || mv.second == 7))
-      score += 1000.0;
+      score += 1000;
     else if (((mv.first == 0 || mv.first == 7) &&
               (mv.second == 1 || mv.second == 6)) ||
              ((mv.first == 1 || mv.first == 6) &&
               (mv.second == 0 || mv.second == 7)))
-      score -= 500.0;
+      score -= 500;
     else if (mv.first == 0 || mv.first == 7 || mv.second == 0 || mv.second == 7)
-      score += 100.0;
-    BitBoard tmp = bb;
-    int before = bb.getScore(isBlack);
-    if (tmp.makeMove(mv.first, mv.second, isBlack)) {
-      int after = tmp.getScore(isBlack);
-      int flips = after - before - 1;
-      if (flips > 0)
-        score += flips * 10.0;
-    }
-    moveScores.emplace_back(mv, score);
+      score += 100;
+    score += __builtin_popcountll(bb.flipsMask(moves.square(i), isBlack)) * 10;
+    moves.setScore(i, score);
   }
-  std::sort(moveScores.begin(), moveScores.end(),
-            [](const auto &a, const auto &b) { return a.second > b.second; });
-  std::vector<std::pair<int, int>> ordered;
-  ordered.reserve(moveScores.size());
-  for (const auto &ms : moveScores)
-    ordered.push_back(ms.first);
-  return ordered;
+  moves.sortByScore();
 }
 
 REGISTER_AI_AGENT(PlagiatBot, "plagiatBot")
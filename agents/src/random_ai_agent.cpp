@@ -16,14 +16,12 @@ RandomAIAgent::getBestMove(const Board &board, CellState player,
   }
 
   if (isTimeUp(startTime, timeLimit)) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
+    static thread_local std::mt19937 gen(std::random_device{}());
     std::uniform_int_distribution<> dis(0, validMoves.size() - 1);
     return validMoves[dis(gen)];
   }
 
-  static std::random_device rd;
-  static std::mt19937 gen(rd());
+  static thread_local std::mt19937 gen(std::random_device{}());
   std::uniform_int_distribution<> dis(0, validMoves.size() - 1);
 
   return validMoves[dis(gen)];
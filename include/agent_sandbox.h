@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ai_agent_base.h"
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+// Out-of-process agents. A SandboxedAgent is a proxy that forwards every call
+// to a worker process running the real agent, so an agent that hangs, leaks
+// or segfaults only takes its own process down. The referee kills a worker
+// that misses its move deadline and replaces it on the next call.
+//
+// Workers are the host executable re-run with AGENT_WORKER_FLAG, so any
+// program that creates sandboxed agents must forward that flag to
+// runAgentWorker() from main(). Linux only; see isSandboxSupported().
+
+// Thrown when a worker missed its deadline and was killed. The tournament
+// scores this as a timeout rather than a crash.
+class AgentTimeoutError : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct SandboxLimits {
+  // Address space limit of the worker process, 0 for none
+  size_t memoryLimitMB{0};
+  // Slack past the move time limit before the worker is killed, so an agent
+  // that is merely late is still reported the usual way
+  std::chrono::milliseconds killGrace{50};
+};
+
+constexpr const char *AGENT_WORKER_FLAG = "--agent-worker";
+
+// Serves one agent over the sandbox protocol until the referee closes the
+// pipe. Returns the process exit code.
+int runAgentWorker();
+
+bool isSandboxSupported();
+
+// Starts idle workers ahead of time so creating or replacing a sandboxed
+// agent doesn't pay for fork and exec. Safe to call from any thread.
+void prestartAgentWorkers(int count);
+
+class SandboxedAgent : public AIAgentBase {
+public:
+  // type is an agent type registered with REGISTER_AI_AGENT
+  SandboxedAgent(const std::string &type, const std::string &name,
+                 const SandboxLimits &limits = SandboxLimits());
+  ~SandboxedAgent() override;
+
+  SandboxedAgent(const SandboxedAgent &) = delete;
+  SandboxedAgent &operator=(const SandboxedAgent &) = delete;
+
+  std::pair<int, int> getBestMove(const Board &board, CellState player,
+                                  std::chrono::milliseconds timeLimit =
+                                      std::chrono::milliseconds(1000)) override;
+  std::pair<int, int> getBestMoveWithBudget(const Board &board,
+                                            CellState player,
+                                            const TimeBudget &budget) override;
+
+  void onGameStart() override;
+  void onMoveMade(int row, int col, CellState player) override;
+  void onGameEnd(CellState winner) override;
+  void stopPondering() override;
+
+private:
+  std::string type_;
+  SandboxLimits limits_;
+  int pid_ = -1;
+  int requestFd_ = -1;
+  int replyFd_ = -1;
+
+  void ensureWorker();
+  void notify(int kind, int row, int col, CellState player);
+  void killWorker();
+  // Reaps a worker that closed its pipe and describes how it died
+  std::string reapWorker();
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "board.h"
+#include "time_budget.h"
 #include <chrono>
 #include <memory>
 #include <string>
@@ -19,11 +20,30 @@ public:
               std::chrono::milliseconds timeLimit =
                   std::chrono::milliseconds(1000)) = 0;
 
+  // Entry point used by the tournament. The default implementation plays a
+  // forced move straight away when on a game clock, otherwise it allocates
+  // a share of the budget for this move and calls getBestMove with it.
+  // Agents that manage their own clock override this instead.
+  virtual std::pair<int, int> getBestMoveWithBudget(const Board &board,
+                                                    CellState player,
+                                                    const TimeBudget &budget);
+
   // Optional methods that can be overridden for additional functionality
   virtual void onGameStart();
   virtual void onMoveMade(int row, int col, CellState player);
   virtual void onGameEnd(CellState winner);
 
+  // Pondering: thinking on the opponent's time. Hosts that allow it call
+  // setPonderingAllowed(true); an agent that supports it may then keep
+  // searching in a background thread after getBestMove returns, usually on
+  // the reply it expects. The actual reply arrives through onMoveMade, where
+  // the agent keeps that work on a ponder hit and drops it on a miss. The
+  // agent stops pondering when getBestMove is called again and whenever the
+  // host calls stopPondering(), e.g. at the end of a game.
+  void setPonderingAllowed(bool allowed);
+  bool isPonderingAllowed() const { return ponderingAllowed; }
+  virtual void stopPondering();
+
   // Utility methods
   const std::string &getName() const { return name; }
   void setName(const std::string &newName) { name = newName; }
@@ -33,6 +53,7 @@ public:
 protected:
   std::string name;
   std::string author;
+  bool ponderingAllowed = false;
 
   // Helper methods that derived classes can use
   std::vector<std::pair<int, int>> getValidMoves(const Board &board,
@@ -40,6 +61,11 @@ protected:
   bool isValidMove(const Board &board, int row, int col,
                    CellState player) const;
   CellState getOpponent(CellState player) const;
+  // The board in bitboard form, Zobrist hash included. Board stores this
+  // representation, so no per-move conversion is needed.
+  const BitBoard &getBitBoard(const Board &board) const {
+    return board.toBitBoard();
+  }
 
   // Time management
   bool isTimeUp(std::chrono::steady_clock::time_point startTime,
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "move_list.h"
 #include <array>
 #include <cstdint>
 #include <mutex>
@@ -34,10 +35,53 @@ public:
 
   // Canonicalisation
   BitBoard toCanonical() const;
+  // The 8 symmetries of a single bitboard, in the order identity, rot90,
+  // rot180, rot270, mirrorHorizontal, mirrorVertical, mirrorDiag and
+  // mirrorAntiDiag.
+  static std::array<uint64_t, 8> symmetries(uint64_t x);
 
   bool isValidMove(int row, int col, bool isBlack) const;
   std::vector<std::pair<int, int>> getValidMoves(bool isBlack) const;
+  // Allocation-free form for search code; replaces the contents of moves
+  void getValidMoves(bool isBlack, MoveList &moves) const;
+  // Bit i is set when square i (row * 8 + col) is a legal move
+  uint64_t legalMovesMask(bool isBlack) const;
+  static uint64_t legalMovesMask(uint64_t player, uint64_t opponent);
   bool makeMove(int row, int col, bool isBlack);
+  // Plays a move already known to be legal (bit = row * 8 + col) and returns
+  // the discs it flipped. Flips are computed once; no legality check.
+  uint64_t makeMoveUnchecked(int bit, bool isBlack);
+  // Everything needed to take a move back in O(1): the flipped discs, the
+  // placed square and the hash before the move.
+  struct Undo {
+    uint64_t flips = 0;
+    uint64_t hash = 0;
+    int square = -1;
+    bool isBlack = false;
+  };
+  // Make/unmake pair for searching on a single board instead of copying it
+  // per child. makeMove() returns false and leaves undo untouched if the move
+  // is illegal; unmakeMove() must be given the records in reverse order.
+  bool makeMove(int bit, bool isBlack, Undo &undo);
+  void unmakeMove(const Undo &undo);
+  uint64_t flipsMask(int bit, bool isBlack) const;
+  static uint64_t flipsMask(int bit, uint64_t player, uint64_t opponent);
+  // Batched forms for independent positions: entry i of the output is the
+  // result for entry i of the inputs. A zero move mask yields no flips.
+  static void legalMovesMaskBatch(const uint64_t *player,
+                                  const uint64_t *opponent, uint64_t *moves,
+                                  int count);
+  static void flipsMaskBatch(const uint64_t *move, const uint64_t *player,
+                             const uint64_t *opponent, uint64_t *flips,
+                             int count);
+
+  // Kernels behind legalMovesMask()/flipsMask(). The fastest supported one is
+  // picked from the CPU features on first use; all backends give identical
+  // results. setBackend() returns false if the CPU lacks the backend.
+  enum class Backend { SCALAR, AVX2 };
+  static Backend getBackend();
+  static bool setBackend(Backend backend);
+  static bool isBackendSupported(Backend backend);
   bool isGameOver() const;
   bool hasValidMoves(bool isBlack) const;
 
@@ -62,11 +106,22 @@ public:
 
   uint64_t getCornerMask() const;
   uint64_t getEdgeMask() const;
+  // Discs of either colour that can never be flipped again
   uint64_t getStableMask() const;
+  // Stable discs of one colour. Uses exact edge tables, lines that are
+  // completely filled and propagation from stable neighbours, so the result
+  // is a subset of the truly stable discs.
+  uint64_t getStableDiscs(bool isBlack) const;
+  static uint64_t stableDiscs(uint64_t player, uint64_t opponent);
 
   static void initializeZobrist(uint64_t seed = 0);
   uint64_t getZobristHash() const;
   uint64_t getZobristHash(bool blackToMove) const;
+  // Hashes of the position after isBlack plays bit, flipping flipped, without
+  // playing it; for prefetching a child's table entry
+  uint64_t getZobristHashAfter(int bit, uint64_t flipped, bool isBlack) const;
+  uint64_t getZobristHashAfter(int bit, uint64_t flipped, bool isBlack,
+                               bool blackToMove) const;
   static uint64_t getZobristKey(int row, int col, int player);
   uint64_t getCanonicalZobristHash() const;
 
@@ -81,7 +136,22 @@ private:
 
   static uint64_t shiftMask(uint64_t board, int dr, int dc);
 
+  void applyMove(int bit, uint64_t flipped, bool isBlack);
+  static uint64_t flipHashDelta(uint64_t flipped);
+  static uint64_t computeHash(uint64_t black, uint64_t white);
+  // Index of the smallest of the 8 symmetric positions, as ordered by
+  // operator<; sb and sw are the symmetries() of the two colours.
+  static int canonicalIndex(const std::array<uint64_t, 8> &sb,
+                            const std::array<uint64_t, 8> &sw);
+
   static std::array<std::array<std::array<uint64_t, 2>, 8>, 8> zobristTable;
+  // zobristFlipFold[i][b]: hash delta of flipping the discs of byte value b
+  // on row i, so a whole flip mask costs 8 lookups instead of a bit loop.
+  static std::array<std::array<uint64_t, 256>, 8> zobristFlipFold;
+  // zobristPlaceFold[p][i][b]: hash of player p owning the discs of byte
+  // value b on row i, so hashing a whole board costs 16 lookups.
+  static std::array<std::array<std::array<uint64_t, 256>, 8>, 2>
+      zobristPlaceFold;
   static uint64_t zobristBlackToMoveKey;
   static std::once_flag zobristOnce;
   static bool zobristInitialised;
@@ -98,14 +168,7 @@ private:
     return x;
   }
 
-  static uint64_t flipVertical(uint64_t x) {
-    const uint64_t k1 = 0x00FF00FF00FF00FFULL;
-    const uint64_t k2 = 0x0000FFFF0000FFFFULL;
-    x = ((x >> 8) & k1) | ((x & k1) << 8);
-    x = ((x >> 16) & k2) | ((x & k2) << 16);
-    x = (x >> 32) | (x << 32);
-    return x;
-  }
+  static uint64_t flipVertical(uint64_t x) { return __builtin_bswap64(x); }
 
   static uint64_t flipDiagonal(uint64_t x) {
     uint64_t t;
@@ -123,16 +186,17 @@ private:
   }
 
   static uint64_t flipAntiDiagonal(uint64_t x) {
-    uint64_t result = 0ULL;
-    for (int r = 0; r < 8; ++r) {
-      for (int c = 0; c < 8; ++c) {
-        int fromBit = r * 8 + c;
-        int toBit = (7 - c) * 8 + (7 - r); // Flip anti-diagonal
-        if (x & (1ULL << fromBit)) {
-          result |= (1ULL << toBit);
-        }
-      }
-    }
-    return result;
+    uint64_t t;
+    const uint64_t k1 = 0xaa00aa00aa00aa00ULL;
+    const uint64_t k2 = 0xcccc0000cccc0000ULL;
+    const uint64_t k4 = 0xf0f0f0f00f0f0f0fULL;
+
+    t = x ^ (x << 36);
+    x ^= k4 & (t ^ (x >> 36));
+    t = k2 & (x ^ (x << 18));
+    x ^= t ^ (t >> 18);
+    t = k1 & (x ^ (x << 9));
+    x ^= t ^ (t >> 9);
+    return x;
   }
 };
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "bitboard.h"
+#include "move_list.h"
 #include <array>
 #include <utility>
 #include <vector>
@@ -27,6 +29,7 @@ public:
   // Game state
   bool isValidMove(int row, int col, CellState player) const;
   std::vector<std::pair<int, int>> getValidMoves(CellState player) const;
+  void getValidMoves(CellState player, MoveList &moves) const;
   bool makeMove(int row, int col, CellState player);
   bool isGameOver() const;
   bool hasValidMoves(CellState player) const;
@@ -48,12 +51,15 @@ public:
   std::vector<std::pair<int, int>> getFlippedDiscs(int row, int col,
                                                    CellState player) const;
 
+  // Conversions to and from the bitboard representation the board is
+  // stored in; both are plain copies.
+  const BitBoard &toBitBoard() const { return bits; }
+  static Board fromBitBoard(const BitBoard &bitboard);
+
 private:
-  std::array<std::array<CellState, BOARD_SIZE>, BOARD_SIZE> grid;
+  BitBoard bits;
 
-  // Helper functions
-  bool checkDirection(int row, int col, Direction dir, CellState player) const;
-  std::vector<std::pair<int, int>>
-  getDiscsInDirection(int row, int col, Direction dir, CellState player) const;
-  static std::pair<int, int> getDirectionOffset(Direction dir);
+  static bool isBlack(CellState player) { return player == CellState::BLACK; }
+  uint64_t playerMask(CellState player) const;
+  uint64_t opponentMask(CellState player) const;
 };
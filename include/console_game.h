@@ -56,12 +56,15 @@ private:
   int passCount;
 
   std::chrono::milliseconds aiTimeLimit;
+  // Whether AI agents may keep thinking during the other side's turn
+  bool aiPondering;
 
   void clearScreen();
   void waitForKeyPress();
   std::string getPlayerName(CellState player) const;
   std::string getAIAgentTypeString(AIAgentType type) const;
   AIAgentBase *createAIAgent(AIAgentType type, const std::string &name);
+  void notifyMoveMade(int row, int col, CellState player);
   void displayMenu();
   void displayAIAgentMenu();
   int getMenuChoice(int min, int max);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+
+// Zeroed memory for large tables probed at random, such as transposition
+// tables and search trees.
+//
+// With 4 KB pages, random probes over tens of megabytes miss the TLB on
+// almost every access. On Linux the buffer is mapped on 2 MB pages instead:
+// explicit huge pages when the system has some reserved, else a 2 MB
+// aligned mapping with transparent huge pages requested through madvise.
+// Small buffers, other systems and failed mappings fall back to the heap.
+//
+// Mapped pages are faulted in up front, so no search pays for page faults;
+// with huge pages a fault may wait on the kernel compacting memory, long
+// enough to blow a move's time. The kernel places each page on the NUMA
+// node of the thread that first writes it, so an owner that resets the
+// buffer before first use builds it with faultIn off and lets reset() place
+// the pages. reset(threads) hands the pages back and faults them in again
+// from that many threads, each taking a slice: search threads float across
+// the machine's CPUs, and the table spreads across the nodes they run on
+// instead of piling up on one thread's node. An agent resetting its table
+// in onGameStart() with its search thread count does just that.
+class LargePageBuffer {
+public:
+  enum class Backing {
+    EXPLICIT_HUGE_PAGES,
+    TRANSPARENT_HUGE_PAGES,
+    HEAP,
+  };
+
+  // For judging TLB reach; read from the kernel, so not for hot paths
+  struct Stats {
+    Backing backing;
+    size_t bytes;
+    // In memory: the pages faulted in and not reclaimed since
+    size_t residentBytes;
+    // Resident bytes the kernel backs with huge pages
+    size_t hugePageBytes;
+  };
+
+  // Mapped memory comes zeroed either way; without faultIn its pages are
+  // only touched by reset() or by the owner's first writes
+  explicit LargePageBuffer(size_t bytes, bool faultIn = true);
+  ~LargePageBuffer();
+
+  LargePageBuffer(const LargePageBuffer &) = delete;
+  LargePageBuffer &operator=(const LargePageBuffer &) = delete;
+
+  void *data() const { return data_; }
+  size_t size() const { return bytes_; }
+  Backing backing() const { return backing_; }
+
+  // Zeroes the whole buffer from threads threads, the calling one included,
+  // placing mapped pages afresh
+  void reset(int threads = 1);
+
+  Stats stats() const;
+  static const char *backingName(Backing backing);
+
+private:
+  static constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+  static constexpr size_t SMALL_PAGE_SIZE = 4096;
+
+  void *data_ = nullptr;
+  size_t bytes_ = 0;
+  // Length of the mapping, a multiple of HUGE_PAGE_SIZE
+  size_t mappedBytes_ = 0;
+  Backing backing_ = Backing::HEAP;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+// Fixed-capacity move list for search code. It lives on the stack, so
+// generating, scoring and ordering moves at a node never touches the heap.
+// Moves are stored as square indices (row * 8 + col) with an ordering score.
+class MoveList {
+public:
+  // No Othello position has more than 33 legal moves; one slot per square
+  // keeps push() free of bounds checks.
+  static constexpr int CAPACITY = 64;
+
+  MoveList() : count(0) {}
+  explicit MoveList(uint64_t mask) : count(0) { assign(mask); }
+
+  // Replaces the contents with the set bits of mask, in square order.
+  void assign(uint64_t mask) {
+    count = 0;
+    while (mask) {
+      squares[count] = static_cast<uint8_t>(__builtin_ctzll(mask));
+      scores[count] = 0;
+      ++count;
+      mask &= mask - 1;
+    }
+  }
+
+  void push(int square, int score = 0) {
+    squares[count] = static_cast<uint8_t>(square);
+    scores[count] = score;
+    ++count;
+  }
+
+  void clear() { count = 0; }
+  int size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  int square(int i) const { return squares[i]; }
+  int score(int i) const { return scores[i]; }
+  void setScore(int i, int score) { scores[i] = score; }
+
+  // Move i as (row, col)
+  std::pair<int, int> operator[](int i) const {
+    return {squares[i] >> 3, squares[i] & 7};
+  }
+
+  // Index of the given square, or -1 if it is not in the list
+  int find(int square) const {
+    for (int i = 0; i < count; ++i) {
+      if (squares[i] == square)
+        return i;
+    }
+    return -1;
+  }
+
+  // Stable insertion sort, highest score first. Lists are short enough that
+  // this beats std::sort and keeps generation order between equal scores.
+  void sortByScore() {
+    for (int i = 1; i < count; ++i) {
+      uint8_t sq = squares[i];
+      int sc = scores[i];
+      int j = i;
+      for (; j > 0 && scores[j - 1] < sc; --j) {
+        squares[j] = squares[j - 1];
+        scores[j] = scores[j - 1];
+      }
+      squares[j] = sq;
+      scores[j] = sc;
+    }
+  }
+
+  // Moves the given square to the front, keeping the order of the others.
+  // Returns false if the square is not in the list.
+  bool moveToFront(int square) {
+    int i = find(square);
+    if (i < 0)
+      return false;
+    uint8_t sq = squares[i];
+    int sc = scores[i];
+    for (; i > 0; --i) {
+      squares[i] = squares[i - 1];
+      scores[i] = scores[i - 1];
+    }
+    squares[0] = sq;
+    scores[0] = sc;
+    return true;
+  }
+
+private:
+  int count;
+  uint8_t squares[CAPACITY];
+  int scores[CAPACITY];
+};
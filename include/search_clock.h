@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Deadline keeping for a search, shared by the search agents.
+//
+// timeUp() is meant to be called once per node. It only reads the clock
+// every `stride` calls. Each search starts with a short stride and grows it
+// over the first few reads until reads happen about every POLL_INTERVAL;
+// if nodes get slower the stride shrinks at once to match.
+//
+// A search has a soft deadline, after which no new iteration should start,
+// and a hard deadline, after which it must unwind. Once the hard deadline
+// has passed or stop() was called, timeUp() keeps returning true until the
+// next start(). stop() may be called from any thread.
+class SearchClock {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  SearchClock() = default;
+  SearchClock(const SearchClock &) = delete;
+  SearchClock &operator=(const SearchClock &) = delete;
+
+  void start(std::chrono::milliseconds softLimit,
+             std::chrono::milliseconds hardLimit);
+  void start(std::chrono::milliseconds limit) { start(limit, limit); }
+
+  // Per-node check, true once the search must stop
+  bool timeUp() {
+    if (stopped_.load(std::memory_order_relaxed))
+      return true;
+    if (--countdown_ > 0)
+      return false;
+    return poll();
+  }
+
+  // Reads the clock now; for checks between root moves
+  bool hardTimeUp();
+  bool softTimeUp() const { return Clock::now() >= softDeadline_; }
+
+  void stop() { stopped_.store(true, std::memory_order_relaxed); }
+  bool stopped() const { return stopped_.load(std::memory_order_relaxed); }
+
+  // Iterative deepening. Call iterationDone() after each completed depth;
+  // nextIterationFits() then says whether another one is worth starting:
+  // not past the soft deadline, and, going by the branching factor between
+  // the last two iterations, likely to finish before the hard deadline.
+  void iterationDone();
+  bool nextIterationFits() const;
+  // Node ratio between the last two completed iterations, 0 if unknown
+  double branchingFactor() const;
+
+  // Nodes counted by timeUp() since start()
+  uint64_t nodes() const {
+    return polledNodes_ + static_cast<uint64_t>(stride_ - countdown_);
+  }
+  std::chrono::milliseconds elapsed() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                                 startTime_);
+  }
+
+private:
+  static constexpr std::chrono::microseconds POLL_INTERVAL{100};
+  static constexpr int32_t MIN_STRIDE = 16;
+  static constexpr int32_t MAX_STRIDE = 1 << 16;
+  // Largest step up per read, so one fast stretch can't overshoot
+  static constexpr int32_t MAX_GROWTH = 2;
+
+  bool poll();
+
+  std::atomic<bool> stopped_{false};
+  int32_t stride_ = MIN_STRIDE;
+  int32_t countdown_ = MIN_STRIDE;
+  uint64_t polledNodes_ = 0;
+
+  Clock::time_point startTime_;
+  Clock::time_point softDeadline_;
+  Clock::time_point hardDeadline_;
+  Clock::time_point lastPoll_;
+
+  Clock::time_point iterationStart_;
+  uint64_t iterationStartNodes_ = 0;
+  Clock::duration lastIterationTime_{0};
+  uint64_t lastIterationNodes_ = 0;
+  uint64_t previousIterationNodes_ = 0;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed-point scores shared by the alpha-beta agents and the transposition
+// table.
+//
+// Evaluations count in hundredths of the evaluators' units, so weighted
+// ratios such as mobility keep two decimals and every sum and comparison is
+// exact integer arithmetic. A heuristic evaluation stays well inside
+// ±MAX_EVALUATION.
+//
+// A finished game scores WIN_SCORE plus the disc margin for the winner, its
+// negation for the loser and 0 for a draw, so any win ranks above any
+// evaluation and bigger wins above smaller ones. SCORE_INFINITY bounds every
+// score, as the initial alpha-beta window; it negates safely and fits the
+// 24 bits the transposition table keeps.
+using Score = int32_t;
+
+constexpr Score SCORE_SCALE = 100;
+constexpr Score WIN_SCORE = Score{1} << 21;
+constexpr Score MAX_EVALUATION = WIN_SCORE - 64;
+constexpr Score SCORE_INFINITY = Score{1} << 22;
+
+// Score of a finished game for the side holding discs against opponentDiscs
+constexpr Score finalScore(int discs, int opponentDiscs) {
+  int margin = discs - opponentDiscs;
+  return margin > 0 ? WIN_SCORE + margin : margin < 0 ? margin - WIN_SCORE : 0;
+}
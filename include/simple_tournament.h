@@ -57,11 +57,30 @@ struct AgentStats {
 
 struct TournamentConfig {
   std::chrono::milliseconds timeLimit{5000};
+  // Game clock: each agent gets gameTime for the whole game, plus increment
+  // after every move it completes. Zero keeps the fixed per-move timeLimit.
+  std::chrono::milliseconds gameTime{0};
+  std::chrono::milliseconds increment{0};
   int roundsPerMatchup{1};
   bool enableVisualFeedback{true};
   bool logGames{true};
   std::string logFile{"tournament.log"};
   std::string tournamentType{"round_robin"};
+  // Games played concurrently. Each worker thread builds its own agent
+  // instances, so agents never share state across games in flight.
+  int threads{1};
+  // Pin each worker thread to its own CPU so concurrent games don't take
+  // time from each other's clocks (Linux only, ignored elsewhere)
+  bool pinThreads{false};
+  // Run every agent in its own worker process (see agent_sandbox.h), so a
+  // hung agent is killed at its deadline and a crash only loses the game
+  bool sandboxAgents{false};
+  // Per-agent address space limit for sandboxed agents, 0 for none
+  size_t agentMemoryLimitMB{0};
+  // Let agents keep searching while the opponent thinks. To keep this fair
+  // each side of a game gets its own CPU, so it needs two CPUs per parallel
+  // game and is turned off when there are fewer (Linux only).
+  bool allowPondering{false};
 
   TournamentConfig() = default;
   TournamentConfig(std::chrono::milliseconds limit, int rounds = 1)
@@ -105,19 +124,47 @@ public:
   GameResult playSingleGame(AIAgentBase *blackAgent, AIAgentBase *whiteAgent);
 
 private:
+  // One game of the schedule: indices into agents_ for each colour
+  struct ScheduledGame {
+    size_t black;
+    size_t white;
+    int round;
+    bool reversed;
+  };
+
   std::vector<std::unique_ptr<AIAgentBase>> agents_;
+  // Factory type of each agent, empty when it was added as an instance and
+  // can't be recreated for a worker thread
+  std::vector<std::string> agentTypes_;
   std::vector<GameResult> gameResults_;
   std::map<std::string, AgentStats> agentStats_;
   TournamentConfig config_;
   ProgressCallback progressCallback_;
 
+  std::vector<ScheduledGame> buildRoundRobinSchedule() const;
+  std::string matchupLabel(const ScheduledGame &game) const;
+  void playSchedule(const std::vector<ScheduledGame> &schedule,
+                    bool sandboxed, bool pondering);
+  void playScheduleParallel(const std::vector<ScheduledGame> &schedule,
+                            int threads, bool sandboxed, bool pondering);
+  bool canCreateWorkerAgents() const;
+  std::unique_ptr<AIAgentBase> createWorkerAgent(size_t index,
+                                                 bool sandboxed) const;
+
+  // sideCpus holds the CPU each colour runs on (black first), or is empty
+  // to leave the thread where it is
+  GameResult playGame(AIAgentBase *blackAgent, AIAgentBase *whiteAgent,
+                      bool pondering, const std::vector<int> &sideCpus);
+
   void updateStats(const GameResult &result);
   void printProgress(int current, int total,
                      const std::string &currentMatch) const;
   std::string formatDuration(std::chrono::milliseconds duration) const;
+  std::string timeControlLabel() const;
 
   std::pair<int, int> getSafeMove(AIAgentBase *agent, const Board &board,
-                                  CellState player,
-                                  const std::string &agentName, bool &timedOut,
-                                  bool &crashed);
+                                  CellState player, const TimeBudget &budget,
+                                  const std::string &agentName,
+                                  std::chrono::steady_clock::duration &elapsed,
+                                  bool &timedOut, bool &crashed);
 };
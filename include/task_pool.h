@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool for fork-join searches.
+//
+// A pool of n threads starts n - 1 workers; the thread that submits work and
+// waits on it makes up the n-th. Every thread has its own task deque: it
+// pushes and pops its own tasks at the back, depth first, while idle threads
+// steal from the front, where the oldest and usually largest tasks are.
+// A thread waiting on a group runs queued tasks instead of blocking, so
+// nested fork-join doesn't starve the pool.
+//
+// Only one thread outside the pool may submit to it at a time.
+class TaskPool {
+public:
+  // Tasks submitted together and waited on together
+  class Group {
+  public:
+    Group() = default;
+    Group(const Group &) = delete;
+    Group &operator=(const Group &) = delete;
+
+  private:
+    friend class TaskPool;
+    std::atomic<int> pending_{0};
+  };
+
+  explicit TaskPool(int threads);
+  ~TaskPool();
+
+  TaskPool(const TaskPool &) = delete;
+  TaskPool &operator=(const TaskPool &) = delete;
+
+  int threads() const { return static_cast<int>(queues_.size()); }
+
+  void submit(Group &group, std::function<void()> task);
+  // Returns once every task of group has run, running tasks meanwhile
+  void wait(Group &group);
+
+  // Index of the calling thread in the pool it is working for: 1 to n - 1
+  // for workers, 0 for any other thread
+  static int currentThread();
+
+private:
+  struct Task {
+    std::function<void()> run;
+    Group *group;
+  };
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<int> queued_{0};
+
+  std::mutex sleepMutex_;
+  std::condition_variable wakeUp_;
+  bool stopping_ = false;
+
+  void workerLoop(int index);
+  // Pops from the caller's own queue, else steals from the others
+  bool runOneTask(int index);
+};
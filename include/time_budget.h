@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+// Time an agent has for its next move. In per-move mode only moveLimit
+// matters. With a game clock the agent owns a bank of time for the whole game
+// (plus a Fischer increment added after every move) and decides itself how
+// much of it to spend; moveLimit is then the whole bank, the point at which
+// its flag falls.
+struct TimeBudget {
+  // Hard limit for this move
+  std::chrono::milliseconds moveLimit{1000};
+  // Time left on the agent's clock before this move, equal to moveLimit
+  // in per-move mode
+  std::chrono::milliseconds remaining{1000};
+  // Added to the clock after each completed move
+  std::chrono::milliseconds increment{0};
+  // Moves this agent has already played in the game
+  int movesPlayed{0};
+  bool gameClock{false};
+
+  TimeBudget() = default;
+
+  static TimeBudget perMove(std::chrono::milliseconds limit) {
+    TimeBudget budget;
+    budget.moveLimit = limit;
+    budget.remaining = limit;
+    return budget;
+  }
+
+  static TimeBudget clock(std::chrono::milliseconds remaining,
+                          std::chrono::milliseconds increment,
+                          int movesPlayed) {
+    TimeBudget budget;
+    budget.moveLimit = remaining;
+    budget.remaining = remaining;
+    budget.increment = increment;
+    budget.movesPlayed = movesPlayed;
+    budget.gameClock = true;
+    return budget;
+  }
+
+  // Time worth spending on this move when the agent still has movesToGo
+  // moves to play, counting this one. A per-move limit is returned as is.
+  // On a clock the bank is split evenly over the remaining moves with most
+  // of the increment on top, and never more than half the bank goes into a
+  // single move so a slow move can't flag.
+  std::chrono::milliseconds allocate(int movesToGo) const {
+    if (!gameClock) {
+      return moveLimit;
+    }
+    auto share = remaining / std::max(movesToGo, 1) + increment * 3 / 4;
+    return std::max(std::chrono::milliseconds(1),
+                    std::min(share, remaining / 2));
+  }
+};
@@ -30,7 +30,10 @@ private:
   void configureTournament();
   void configureTournamentType();
   void configureTimeLimit();
+  void configureGameClock();
   void configureRounds();
+  void configureThreads();
+  void configureSandbox();
   void setupAllAgents();
 
   // Tournament execution
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "large_page_buffer.h"
+#include "search_score.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+// What a stored score says about the position's value
+enum class TTBound : uint8_t { EXACT, LOWER_BOUND, UPPER_BOUND };
+
+// Fixed-size transposition table shared by the search agents.
+//
+// An entry is a single 64-bit word: 21 bits of the key, the score in 24
+// bits, the depth, the bound, the best move and the generation of the
+// search that stored it. Eight entries make a 64-byte bucket, aligned to a
+// cache line; the low bits of the key pick the bucket and the high bits
+// are the ones stored, so together most of the key is checked. Buckets
+// live in a LargePageBuffer, on huge pages where the system allows.
+//
+// The table may be shared by search threads without locks. An entry is
+// read and written as one word, so a probe sees either the old entry or
+// the new one, never a mix.
+//
+// Replacement keeps the deepest, most recent entries: a new position
+// takes an empty slot if the bucket has one, else the slot whose depth,
+// less 8 per search since it was written, is lowest.
+//
+// Entries stay usable from one search to the next, so agents call
+// newSearch() per move, which is O(1). Keys cover the whole position, so
+// entries stay valid from one game to the next too: newGame() keeps them
+// unless the table was built with clearEachGame, for games that must not
+// depend on earlier ones, such as reproducing a result.
+//
+// The first newGame() also places the table's pages, from the number of
+// threads the owner searches with; see LargePageBuffer. A table searched
+// before that faults its pages in as probes reach them.
+class TranspositionTable {
+public:
+  static constexpr int NO_MOVE = -1;
+  // Deeper entries are stored as this deep
+  static constexpr int MAX_DEPTH = 63;
+
+  struct Entry {
+    Score score;
+    int depth;
+    TTBound bound;
+    // Square of the best move, or NO_MOVE
+    int move;
+  };
+
+  // Rounded down to a power of two buckets
+  explicit TranspositionTable(size_t megabytes, bool clearEachGame = false)
+      : buffer_(bucketCount(megabytes) * sizeof(Bucket), false),
+        buckets_(static_cast<Bucket *>(buffer_.data())),
+        mask_(bucketCount(megabytes) - 1), clearEachGame_(clearEachGame) {
+    // The buffer comes zeroed, which reads as empty slots
+    std::uninitialized_default_construct_n(buckets_, mask_ + 1);
+  }
+
+  TranspositionTable(const TranspositionTable &) = delete;
+  TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+  // Not while a search is using the table; threads as for newGame()
+  void clear(int threads = 1) {
+    buffer_.reset(threads);
+    placed_ = true;
+    generation_.store(0, std::memory_order_relaxed);
+  }
+
+  // Call at the start of each game, not while a search is using the table,
+  // with the number of threads that will search it
+  void newGame(int threads = 1) {
+    if (clearEachGame_ || !placed_)
+      clear(threads);
+  }
+
+  // Call once per search, so entries from earlier ones age out first
+  void newSearch() {
+    generation_.store((generation_.load(std::memory_order_relaxed) + 1) &
+                          GENERATION_MASK,
+                      std::memory_order_relaxed);
+  }
+
+  bool probe(uint64_t key, Entry &entry) const {
+    const Bucket &bucket = buckets_[key & mask_];
+    for (const std::atomic<uint64_t> &slot : bucket.slots) {
+      uint64_t data = slot.load(std::memory_order_relaxed);
+      if (occupied(data) && tagOf(data) == keyTag(key)) {
+        entry = decode(data);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Starts loading the key's bucket into cache. Issued for all of a node's
+  // children before searching them, the misses overlap with each other and
+  // with the search of the first child instead of stalling each probe.
+  void prefetch(uint64_t key) const {
+    __builtin_prefetch(&buckets_[key & mask_]);
+  }
+
+  // score must lie within ±SCORE_INFINITY
+  void store(uint64_t key, Score score, int depth, TTBound bound,
+             int move = NO_MOVE) {
+    Bucket &bucket = buckets_[key & mask_];
+    unsigned generation = generation_.load(std::memory_order_relaxed);
+    std::atomic<uint64_t> *victim = nullptr;
+    int victimValue = 0;
+    for (std::atomic<uint64_t> &slot : bucket.slots) {
+      uint64_t data = slot.load(std::memory_order_relaxed);
+      if (!occupied(data)) {
+        if (!victim || victimValue != EMPTY) {
+          victim = &slot;
+          victimValue = EMPTY;
+        }
+        continue;
+      }
+      Entry old = decode(data);
+      if (tagOf(data) == keyTag(key)) {
+        if (depth >= old.depth || bound == TTBound::EXACT ||
+            old.bound != TTBound::EXACT || generationOf(data) != generation) {
+          slot.store(encode(key, score, depth, bound,
+                            move == NO_MOVE ? old.move : move, generation),
+                     std::memory_order_relaxed);
+        }
+        return;
+      }
+      int age = (generation - generationOf(data)) & GENERATION_MASK;
+      int value = old.depth - 8 * age;
+      if (!victim || value < victimValue) {
+        victim = &slot;
+        victimValue = value;
+      }
+    }
+    victim->store(encode(key, score, depth, bound, move, generation),
+                  std::memory_order_relaxed);
+  }
+
+  size_t capacity() const { return (mask_ + 1) * WAYS; }
+  LargePageBuffer::Stats memoryStats() const { return buffer_.stats(); }
+  size_t bytes() const { return (mask_ + 1) * sizeof(Bucket); }
+  // Occupied entries, counting every slot; for diagnostics
+  size_t entries() const {
+    size_t count = 0;
+    for (size_t b = 0; b <= mask_; ++b) {
+      for (const std::atomic<uint64_t> &slot : buckets_[b].slots) {
+        if (occupied(slot.load(std::memory_order_relaxed)))
+          ++count;
+      }
+    }
+    return count;
+  }
+
+private:
+  // A slot packs the key's top 21 bits in bits 0-20, the score in 21-44,
+  // the depth in 45-50, the bound plus one in 51-52 (0 for an empty slot),
+  // the generation in 53-56 and the best move's square in 57-63 (0x7F for
+  // none)
+  static constexpr int WAYS = 8;
+  struct alignas(64) Bucket {
+    // No initializers, the buffer comes zeroed
+    std::atomic<uint64_t> slots[WAYS];
+  };
+  static_assert(sizeof(Bucket) == 64, "a bucket should fill a cache line");
+  static_assert(SCORE_INFINITY < (Score{1} << 23),
+                "scores must fit in 24 bits");
+  static constexpr unsigned GENERATION_MASK = 0xF;
+  static constexpr uint64_t NO_SQUARE = 0x7F;
+  // Replacement value of an empty slot, below that of any entry
+  static constexpr int EMPTY = std::numeric_limits<int>::min();
+
+  static size_t bucketCount(size_t megabytes) {
+    size_t buckets = (megabytes << 20) / sizeof(Bucket);
+    size_t count = 1;
+    while (count * 2 <= buckets) {
+      count *= 2;
+    }
+    return count;
+  }
+
+  // The key's top bits, clear of the ones picking the bucket
+  static uint64_t keyTag(uint64_t key) { return key >> 43; }
+  static uint64_t tagOf(uint64_t data) { return data & 0x1FFFFF; }
+  static bool occupied(uint64_t data) { return (data >> 51 & 0x3) != 0; }
+  static unsigned generationOf(uint64_t data) {
+    return static_cast<unsigned>(data >> 53) & GENERATION_MASK;
+  }
+
+  static Entry decode(uint64_t data) {
+    Entry entry;
+    // Sign-extends the score from 24 bits
+    entry.score = static_cast<Score>(static_cast<int64_t>(data << 19) >> 40);
+    entry.depth = static_cast<int>(data >> 45 & 0x3F);
+    entry.bound = static_cast<TTBound>((data >> 51 & 0x3) - 1);
+    uint64_t square = data >> 57;
+    entry.move = square == NO_SQUARE ? NO_MOVE : static_cast<int>(square);
+    return entry;
+  }
+
+  static uint64_t encode(uint64_t key, Score score, int depth, TTBound bound,
+                         int move, unsigned generation) {
+    uint64_t square = move == NO_MOVE ? NO_SQUARE : static_cast<uint64_t>(move);
+    uint64_t clamped = depth < 0 ? 0 : depth > MAX_DEPTH ? MAX_DEPTH : depth;
+    return keyTag(key) |
+           (static_cast<uint64_t>(score) & 0xFFFFFF) << 21 | clamped << 45 |
+           (static_cast<uint64_t>(bound) + 1) << 51 |
+           static_cast<uint64_t>(generation) << 53 | square << 57;
+  }
+
+  LargePageBuffer buffer_;
+  Bucket *buckets_;
+  size_t mask_;
+  bool clearEachGame_;
+  // Whether clear() has faulted the pages in yet
+  bool placed_ = false;
+  std::atomic<unsigned> generation_{0};
+};
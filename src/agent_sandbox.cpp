@@ -0,0 +1,541 @@
+#include "agent_sandbox.h"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+namespace {
+
+// Fixed-size message used in both directions. Text (the agent type and name
+// on creation, an error message on failure) follows as payload bytes.
+struct SandboxMessage {
+  uint8_t kind;
+  uint8_t status;
+  uint8_t player;
+  int8_t row;
+  int8_t col;
+  uint8_t flags;
+  uint16_t movesPlayed;
+  uint32_t value;     // move time limit in ms, or memory limit in MB
+  uint32_t payload;   // bytes of text following the message
+  uint32_t remaining; // clock time left in ms
+  uint32_t increment; // clock increment in ms
+  uint64_t black;
+  uint64_t white;
+};
+static_assert(sizeof(SandboxMessage) == 40, "sandbox message layout changed");
+
+enum MessageKind : uint8_t {
+  CREATE,
+  BEST_MOVE,
+  GAME_START,
+  MOVE_MADE,
+  GAME_END,
+  STOP_PONDERING
+};
+enum MessageStatus : uint8_t { OK, FAILED };
+// Flags of a BEST_MOVE request
+enum MessageFlag : uint8_t { GAME_CLOCK = 1, PONDERING = 2 };
+
+// Pipe ends as seen by the worker process
+constexpr int WORKER_IN_FD = 3;
+constexpr int WORKER_OUT_FD = 4;
+
+// Agent construction can allocate large tables, but must not hang forever
+constexpr std::chrono::milliseconds STARTUP_TIMEOUT{10000};
+
+bool writeAll(int fd, const void *data, size_t size) {
+  const char *bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    ssize_t n = write(fd, bytes, size);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    bytes += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool readAll(int fd, void *data, size_t size) {
+  char *bytes = static_cast<char *>(data);
+  while (size > 0) {
+    ssize_t n = read(fd, bytes, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    bytes += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool sendMessage(int fd, SandboxMessage message, const std::string &text) {
+  message.payload = static_cast<uint32_t>(text.size());
+  return writeAll(fd, &message, sizeof(message)) &&
+         writeAll(fd, text.data(), text.size());
+}
+
+enum class ReadResult { DONE, TIMEOUT, CLOSED };
+
+ReadResult readBefore(int fd, void *data, size_t size,
+                      std::chrono::steady_clock::time_point deadline) {
+  char *bytes = static_cast<char *>(data);
+  while (size > 0) {
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0)
+      return ReadResult::TIMEOUT;
+
+    pollfd pfd{fd, POLLIN, 0};
+    int ready = poll(&pfd, 1, static_cast<int>(remaining.count()));
+    if (ready < 0 && errno != EINTR)
+      return ReadResult::CLOSED;
+    if (ready <= 0)
+      continue;
+
+    ssize_t n = read(fd, bytes, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return ReadResult::CLOSED;
+    bytes += n;
+    size -= static_cast<size_t>(n);
+  }
+  return ReadResult::DONE;
+}
+
+// Reads a reply and its payload text before the deadline
+ReadResult readReply(int fd, SandboxMessage &reply, std::string &text,
+                     std::chrono::steady_clock::time_point deadline) {
+  ReadResult result = readBefore(fd, &reply, sizeof(reply), deadline);
+  if (result != ReadResult::DONE)
+    return result;
+  text.assign(reply.payload, '\0');
+  return readBefore(fd, &text[0], text.size(), deadline);
+}
+
+struct WorkerProcess {
+  pid_t pid;
+  int requestFd;
+  int replyFd;
+};
+
+WorkerProcess spawnWorker() {
+  int request[2], reply[2];
+  if (pipe2(request, O_CLOEXEC) != 0) {
+    throw std::runtime_error("agent sandbox: pipe failed");
+  }
+  if (pipe2(reply, O_CLOEXEC) != 0) {
+    close(request[0]);
+    close(request[1]);
+    throw std::runtime_error("agent sandbox: pipe failed");
+  }
+
+  // Built before fork: the child may only make async-signal-safe calls
+  const char *path = "/proc/self/exe";
+  char *const argv[] = {const_cast<char *>(path),
+                        const_cast<char *>(AGENT_WORKER_FLAG), nullptr};
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    // Copy the worker's ends above the fixed descriptors first, in case the
+    // pipes were given 3 or 4. The copies don't inherit O_CLOEXEC.
+    int in = fcntl(request[0], F_DUPFD, 10);
+    int out = fcntl(reply[1], F_DUPFD, 10);
+    if (in < 0 || out < 0 || dup2(in, WORKER_IN_FD) < 0 ||
+        dup2(out, WORKER_OUT_FD) < 0) {
+      _exit(127);
+    }
+    close(in);
+    close(out);
+    execv(path, argv);
+    _exit(127);
+  }
+
+  close(request[0]);
+  close(reply[1]);
+  if (pid < 0) {
+    close(request[1]);
+    close(reply[0]);
+    throw std::runtime_error("agent sandbox: fork failed");
+  }
+  return {pid, request[1], reply[0]};
+}
+
+void destroyWorker(const WorkerProcess &worker) {
+  kill(worker.pid, SIGKILL);
+  close(worker.requestFd);
+  close(worker.replyFd);
+  waitpid(worker.pid, nullptr, 0);
+}
+
+// Idle workers that have been exec'd but not yet told which agent to run
+class WorkerPool {
+public:
+  static WorkerPool &instance() {
+    static WorkerPool pool;
+    return pool;
+  }
+
+  WorkerProcess acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idle_.empty()) {
+      return spawnWorker();
+    }
+    WorkerProcess worker = idle_.back();
+    idle_.pop_back();
+    return worker;
+  }
+
+  void prestart(int count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (static_cast<int>(idle_.size()) < count) {
+      idle_.push_back(spawnWorker());
+    }
+  }
+
+private:
+  WorkerPool() {
+    // A dead worker must show up as a write error, not kill the referee
+    std::signal(SIGPIPE, SIG_IGN);
+  }
+
+  ~WorkerPool() {
+    for (const auto &worker : idle_) {
+      destroyWorker(worker);
+    }
+  }
+
+  std::mutex mutex_;
+  std::vector<WorkerProcess> idle_;
+};
+
+void applyMemoryLimit(uint32_t megabytes) {
+  rlimit core{0, 0};
+  setrlimit(RLIMIT_CORE, &core);
+  if (megabytes == 0)
+    return;
+  rlim_t bytes = static_cast<rlim_t>(megabytes) * 1024 * 1024;
+  rlimit limit{bytes, bytes};
+  setrlimit(RLIMIT_AS, &limit);
+}
+
+} // namespace
+
+int runAgentWorker() {
+  std::unique_ptr<AIAgentBase> agent;
+  SandboxMessage message;
+
+  while (readAll(WORKER_IN_FD, &message, sizeof(message))) {
+    std::string text(message.payload, '\0');
+    if (!readAll(WORKER_IN_FD, &text[0], text.size()))
+      break;
+
+    CellState player = static_cast<CellState>(message.player);
+    SandboxMessage reply{};
+    reply.kind = message.kind;
+    std::string error;
+
+    switch (message.kind) {
+    case CREATE: {
+      applyMemoryLimit(message.value);
+      size_t split = text.find('\0');
+      try {
+        agent = createAIAgent(text.substr(0, split), text.substr(split + 1));
+        if (!agent)
+          error = "unknown agent type " + text.substr(0, split);
+      } catch (const std::exception &e) {
+        error = e.what();
+      }
+      break;
+    }
+    case BEST_MOVE: {
+      Board board = Board::fromBitBoard(BitBoard(message.black, message.white));
+      try {
+        if (!agent)
+          throw std::runtime_error("no agent created");
+        TimeBudget budget;
+        budget.moveLimit = std::chrono::milliseconds(message.value);
+        budget.remaining = std::chrono::milliseconds(message.remaining);
+        budget.increment = std::chrono::milliseconds(message.increment);
+        budget.movesPlayed = message.movesPlayed;
+        budget.gameClock = (message.flags & GAME_CLOCK) != 0;
+        agent->setPonderingAllowed((message.flags & PONDERING) != 0);
+        auto move = agent->getBestMoveWithBudget(board, player, budget);
+        reply.row = static_cast<int8_t>(move.first);
+        reply.col = static_cast<int8_t>(move.second);
+      } catch (const std::exception &e) {
+        error = e.what();
+      } catch (...) {
+        error = "unknown exception";
+      }
+      break;
+    }
+    // Notifications get no reply, like the in-process hooks their failures
+    // are ignored
+    case GAME_START:
+    case MOVE_MADE:
+    case GAME_END:
+    case STOP_PONDERING:
+      try {
+        if (agent && message.kind == GAME_START)
+          agent->onGameStart();
+        else if (agent && message.kind == MOVE_MADE)
+          agent->onMoveMade(message.row, message.col, player);
+        else if (agent && message.kind == STOP_PONDERING)
+          agent->stopPondering();
+        else if (agent)
+          agent->onGameEnd(player);
+      } catch (...) {
+      }
+      continue;
+    default:
+      error = "unknown sandbox message";
+      break;
+    }
+
+    reply.status = error.empty() ? OK : FAILED;
+    if (!sendMessage(WORKER_OUT_FD, reply, error))
+      break;
+  }
+  return 0;
+}
+
+bool isSandboxSupported() { return true; }
+
+void prestartAgentWorkers(int count) { WorkerPool::instance().prestart(count); }
+
+SandboxedAgent::SandboxedAgent(const std::string &type, const std::string &name,
+                               const SandboxLimits &limits)
+    : AIAgentBase(name), type_(type), limits_(limits) {}
+
+SandboxedAgent::~SandboxedAgent() { killWorker(); }
+
+std::pair<int, int>
+SandboxedAgent::getBestMove(const Board &board, CellState player,
+                            std::chrono::milliseconds timeLimit) {
+  return getBestMoveWithBudget(board, player, TimeBudget::perMove(timeLimit));
+}
+
+// The budget is forwarded as is, so the agent in the worker allocates its
+// own time exactly as it would in process
+std::pair<int, int>
+SandboxedAgent::getBestMoveWithBudget(const Board &board, CellState player,
+                                      const TimeBudget &budget) {
+  auto startTime = std::chrono::steady_clock::now();
+  ensureWorker();
+
+  // The referee pins each pondering side to its own CPUs; the worker's
+  // search threads, background ones included, must stay there too
+  if (ponderingAllowed) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0)
+      sched_setaffinity(pid_, sizeof(cpus), &cpus);
+  }
+
+  const BitBoard &bits = board.toBitBoard();
+  SandboxMessage request{};
+  request.kind = BEST_MOVE;
+  request.player = static_cast<uint8_t>(player);
+  request.value = static_cast<uint32_t>(budget.moveLimit.count());
+  request.remaining = static_cast<uint32_t>(budget.remaining.count());
+  request.increment = static_cast<uint32_t>(budget.increment.count());
+  request.movesPlayed = static_cast<uint16_t>(budget.movesPlayed);
+  request.flags = (budget.gameClock ? GAME_CLOCK : 0) |
+                  (ponderingAllowed ? PONDERING : 0);
+  request.black = bits.blackBoard;
+  request.white = bits.whiteBoard;
+  if (!sendMessage(requestFd_, request, "")) {
+    throw std::runtime_error(reapWorker());
+  }
+
+  SandboxMessage reply;
+  std::string error;
+  auto deadline = startTime + budget.moveLimit + limits_.killGrace;
+  switch (readReply(replyFd_, reply, error, deadline)) {
+  case ReadResult::TIMEOUT:
+    killWorker();
+    throw AgentTimeoutError("agent process killed after missing its deadline");
+  case ReadResult::CLOSED:
+    throw std::runtime_error(reapWorker());
+  case ReadResult::DONE:
+    break;
+  }
+
+  if (reply.status != OK) {
+    throw std::runtime_error(error);
+  }
+  return {reply.row, reply.col};
+}
+
+// Creating the agent here rather than in the constructor keeps it off the
+// move clock and lets the tournament's hook error handling cover it
+void SandboxedAgent::onGameStart() {
+  ensureWorker();
+  notify(GAME_START, 0, 0, CellState::EMPTY);
+}
+
+void SandboxedAgent::onMoveMade(int row, int col, CellState player) {
+  notify(MOVE_MADE, row, col, player);
+}
+
+void SandboxedAgent::onGameEnd(CellState winner) {
+  notify(GAME_END, 0, 0, winner);
+}
+
+void SandboxedAgent::stopPondering() {
+  notify(STOP_PONDERING, 0, 0, CellState::EMPTY);
+}
+
+void SandboxedAgent::ensureWorker() {
+  if (pid_ > 0)
+    return;
+
+  WorkerProcess worker = WorkerPool::instance().acquire();
+  pid_ = worker.pid;
+  requestFd_ = worker.requestFd;
+  replyFd_ = worker.replyFd;
+
+  SandboxMessage request{};
+  request.kind = CREATE;
+  request.value = static_cast<uint32_t>(limits_.memoryLimitMB);
+  if (!sendMessage(requestFd_, request, type_ + '\0' + name)) {
+    throw std::runtime_error(reapWorker());
+  }
+
+  SandboxMessage reply;
+  std::string error;
+  auto deadline = std::chrono::steady_clock::now() + STARTUP_TIMEOUT;
+  switch (readReply(replyFd_, reply, error, deadline)) {
+  case ReadResult::TIMEOUT:
+    killWorker();
+    throw std::runtime_error("agent process timed out while starting");
+  case ReadResult::CLOSED:
+    throw std::runtime_error(reapWorker());
+  case ReadResult::DONE:
+    break;
+  }
+
+  if (reply.status != OK) {
+    killWorker();
+    throw std::runtime_error(error);
+  }
+}
+
+void SandboxedAgent::notify(int kind, int row, int col, CellState player) {
+  if (pid_ <= 0)
+    return;
+  SandboxMessage message{};
+  message.kind = static_cast<uint8_t>(kind);
+  message.player = static_cast<uint8_t>(player);
+  message.row = static_cast<int8_t>(row);
+  message.col = static_cast<int8_t>(col);
+  // A worker that died here is noticed and reported on the next move
+  sendMessage(requestFd_, message, "");
+}
+
+void SandboxedAgent::killWorker() {
+  if (pid_ <= 0)
+    return;
+  destroyWorker({pid_, requestFd_, replyFd_});
+  pid_ = -1;
+  requestFd_ = replyFd_ = -1;
+}
+
+std::string SandboxedAgent::reapWorker() {
+  close(requestFd_);
+  close(replyFd_);
+
+  // The worker closed its end, so it is normally already exiting. Give it a
+  // moment, then stop waiting on one that is still running.
+  int status = 0;
+  pid_t done = 0;
+  for (int i = 0; i < 100 && done == 0; ++i) {
+    done = waitpid(pid_, &status, WNOHANG);
+    if (done == 0)
+      usleep(1000);
+  }
+  if (done == 0) {
+    kill(pid_, SIGKILL);
+    waitpid(pid_, &status, 0);
+  }
+  pid_ = -1;
+  requestFd_ = replyFd_ = -1;
+
+  if (done > 0 && WIFSIGNALED(status)) {
+    int sig = WTERMSIG(status);
+    return "agent process killed by signal " + std::to_string(sig) + " (" +
+           strsignal(sig) + ")";
+  }
+  if (done > 0 && WIFEXITED(status)) {
+    return "agent process exited with code " +
+           std::to_string(WEXITSTATUS(status));
+  }
+  return "agent process stopped responding";
+}
+
+#else
+
+int runAgentWorker() {
+  std::cerr << "Agent sandbox is not supported on this platform" << std::endl;
+  return 1;
+}
+
+bool isSandboxSupported() { return false; }
+
+void prestartAgentWorkers(int count) { (void)count; }
+
+SandboxedAgent::SandboxedAgent(const std::string &type, const std::string &name,
+                               const SandboxLimits &limits)
+    : AIAgentBase(name), type_(type), limits_(limits) {}
+
+SandboxedAgent::~SandboxedAgent() = default;
+
+std::pair<int, int>
+SandboxedAgent::getBestMove(const Board &board, CellState player,
+                            std::chrono::milliseconds timeLimit) {
+  (void)board;
+  (void)player;
+  (void)timeLimit;
+  throw std::runtime_error("agent sandbox is not supported on this platform");
+}
+
+std::pair<int, int>
+SandboxedAgent::getBestMoveWithBudget(const Board &board, CellState player,
+                                      const TimeBudget &budget) {
+  return getBestMove(board, player, budget.moveLimit);
+}
+
+void SandboxedAgent::onGameStart() {}
+
+void SandboxedAgent::onMoveMade(int row, int col, CellState player) {
+  (void)row;
+  (void)col;
+  (void)player;
+}
+
+void SandboxedAgent::onGameEnd(CellState winner) { (void)winner; }
+
+void SandboxedAgent::stopPondering() {}
+
+#endif
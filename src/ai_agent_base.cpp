@@ -10,6 +10,21 @@ AIAgentBase::AIAgentBase(const std::string &agentName,
                          const std::string &agentAuthor)
     : name(agentName), author(agentAuthor) {}
 
+std::pair<int, int>
+AIAgentBase::getBestMoveWithBudget(const Board &board, CellState player,
+                                   const TimeBudget &budget) {
+  if (budget.gameClock) {
+    MoveList moves;
+    board.getValidMoves(player, moves);
+    if (moves.size() == 1) {
+      return moves[0];
+    }
+  }
+  // Both sides alternate, so this agent plays about half of the empties
+  int empties = Board::TOTAL_CELLS - board.getTotalDiscs();
+  return getBestMove(board, player, budget.allocate((empties + 1) / 2));
+}
+
 void AIAgentBase::onGameStart() {
   // Default implementation does nothing
 }
@@ -26,6 +41,17 @@ void AIAgentBase::onGameEnd(CellState winner) {
   (void)winner; // Suppress unused parameter warning
 }
 
+void AIAgentBase::setPonderingAllowed(bool allowed) {
+  if (!allowed) {
+    stopPondering();
+  }
+  ponderingAllowed = allowed;
+}
+
+void AIAgentBase::stopPondering() {
+  // Default implementation does nothing
+}
+
 std::vector<std::pair<int, int>>
 AIAgentBase::getValidMoves(const Board &board, CellState player) const {
   return board.getValidMoves(player);
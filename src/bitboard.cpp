@@ -1,9 +1,18 @@
 #include "bitboard.h"
 #include <algorithm>
+#include <atomic>
 #include <bitset>
 #include <cassert>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BITBOARD_AVX2_KERNELS 1
+#endif
+
 std::array<std::array<std::array<uint64_t, 2>, 8>, 8> BitBoard::zobristTable;
+std::array<std::array<uint64_t, 256>, 8> BitBoard::zobristFlipFold;
+std::array<std::array<std::array<uint64_t, 256>, 8>, 2>
+    BitBoard::zobristPlaceFold;
 uint64_t BitBoard::zobristBlackToMoveKey = 0;
 std::once_flag BitBoard::zobristOnce;
 bool BitBoard::zobristInitialised = false;
@@ -13,21 +22,7 @@ BitBoard::BitBoard() { reset(); }
 BitBoard::BitBoard(uint64_t black, uint64_t white)
     : blackBoard(black), whiteBoard(white) {
   initializeZobrist();
-  hash_ = 0;
-  uint64_t tmp = blackBoard;
-  while (tmp) {
-    int bit = __builtin_ctzll(tmp);
-    tmp &= tmp - 1;
-    auto [r, c] = bitToPosition(bit);
-    hash_ ^= zobristTable[r][c][0];
-  }
-  tmp = whiteBoard;
-  while (tmp) {
-    int bit = __builtin_ctzll(tmp);
-    tmp &= tmp - 1;
-    auto [r, c] = bitToPosition(bit);
-    hash_ ^= zobristTable[r][c][1];
-  }
+  hash_ = computeHash(blackBoard, whiteBoard);
 }
 
 void BitBoard::reset() {
@@ -124,8 +119,6 @@ uint64_t BitBoard::getEdgeMask() const {
   return edgeMask;
 }
 
-uint64_t BitBoard::getStableMask() const { return 0ULL; }
-
 uint64_t BitBoard::getOpponentBoard(bool isBlack) const {
   return isBlack ? whiteBoard : blackBoard;
 }
@@ -134,60 +127,397 @@ bool BitBoard::isValidMove(int row, int col, bool isBlack) const {
   if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE) {
     return false;
   }
-  if (getCell(row, col) != 0)
-    return false;
-  return getFlippedBitboard(row, col, isBlack) != 0;
+  return (legalMovesMask(isBlack) & positionToMask(row, col)) != 0;
 }
 
 std::vector<std::pair<int, int>> BitBoard::getValidMoves(bool isBlack) const {
   std::vector<std::pair<int, int>> moves;
-  for (int r = 0; r < BOARD_SIZE; ++r) {
-    for (int c = 0; c < BOARD_SIZE; ++c) {
-      if (isValidMove(r, c, isBlack)) {
-        moves.emplace_back(r, c);
-      }
-    }
+  uint64_t legal = legalMovesMask(isBlack);
+  moves.reserve(__builtin_popcountll(legal));
+  while (legal) {
+    int bit = __builtin_ctzll(legal);
+    legal &= legal - 1;
+    moves.push_back(bitToPosition(bit));
   }
   return moves;
 }
 
-uint64_t BitBoard::getFlippedBitboard(int row, int col, bool isBlack) const {
-  uint64_t flipped = 0;
-  uint64_t playerBoard = getPlayerBoard(isBlack);
-  uint64_t opponentBoard = getOpponentBoard(isBlack);
-  static const std::array<std::pair<int, int>, 8> directions = {
-      std::make_pair(-1, 0), // N
-      std::make_pair(-1, 1), // NE
-      std::make_pair(0, 1),  // E
-      std::make_pair(1, 1),  // SE
-      std::make_pair(1, 0),  // S
-      std::make_pair(1, -1), // SW
-      std::make_pair(0, -1), // W
-      std::make_pair(-1, -1) // NW
-  };
-  for (auto [dr, dc] : directions) {
-    int r = row + dr;
-    int c = col + dc;
-    uint64_t temp = 0;
-    bool foundOpponent = false;
-    while (r >= 0 && r < BOARD_SIZE && c >= 0 && c < BOARD_SIZE) {
-      uint64_t mask = positionToMask(r, c);
-      if (opponentBoard & mask) {
-        temp |= mask;
-        foundOpponent = true;
-      } else if (playerBoard & mask) {
-        if (foundOpponent) {
-          flipped |= temp;
-        }
-        break;
-      } else {
-        break;
-      }
-      r += dr;
-      c += dc;
-    }
+void BitBoard::getValidMoves(bool isBlack, MoveList &moves) const {
+  moves.assign(legalMovesMask(isBlack));
+}
+
+namespace {
+
+// Wrap-around guards: discs on the A/H files must not leak into the next rank
+// when a row is shifted sideways.
+constexpr uint64_t NOT_A_FILE = 0xfefefefefefefefeULL;
+constexpr uint64_t NOT_H_FILE = 0x7f7f7f7f7f7f7f7fULL;
+constexpr uint64_t INNER_FILES = NOT_A_FILE & NOT_H_FILE;
+
+template <int Shift>
+inline uint64_t shiftBits(uint64_t x) {
+  if constexpr (Shift > 0)
+    return x << Shift;
+  else
+    return x >> -Shift;
+}
+
+// dumb7fill in one direction: grow runs of opponent discs starting next to
+// the player's discs, then step once more onto the square behind the run.
+// A line holds at most 6 opponent discs between two squares, hence the
+// fixed 5 extra fill steps.
+template <int Shift>
+inline uint64_t movesInDirection(uint64_t player, uint64_t opponentMask) {
+  uint64_t run = opponentMask & shiftBits<Shift>(player);
+  run |= opponentMask & shiftBits<Shift>(run);
+  run |= opponentMask & shiftBits<Shift>(run);
+  run |= opponentMask & shiftBits<Shift>(run);
+  run |= opponentMask & shiftBits<Shift>(run);
+  run |= opponentMask & shiftBits<Shift>(run);
+  return shiftBits<Shift>(run);
+}
+
+// Same fill, started from the move square: the run of opponent discs is
+// flipped only if a player disc closes it. Selected with a mask, not a branch.
+template <int Shift>
+inline uint64_t flipsInDirection(uint64_t move, uint64_t player,
+                                 uint64_t opponentMask) {
+  uint64_t run = opponentMask & shiftBits<Shift>(move);
+  run |= opponentMask & shiftBits<Shift>(run);
+  run |= opponentMask & shiftBits<Shift>(run);
+  run |= opponentMask & shiftBits<Shift>(run);
+  run |= opponentMask & shiftBits<Shift>(run);
+  run |= opponentMask & shiftBits<Shift>(run);
+  uint64_t closed = shiftBits<Shift>(run) & player;
+  return run & (0 - static_cast<uint64_t>(closed != 0));
+}
+
+uint64_t legalMovesScalar(uint64_t player, uint64_t opponent) {
+  // Horizontal and diagonal runs may not cross the A/H files; vertical runs
+  // fall off the board on their own.
+  const uint64_t inner = opponent & INNER_FILES;
+  uint64_t moves = movesInDirection<1>(player, inner) |
+                   movesInDirection<-1>(player, inner) |
+                   movesInDirection<8>(player, opponent) |
+                   movesInDirection<-8>(player, opponent) |
+                   movesInDirection<7>(player, inner) |
+                   movesInDirection<-7>(player, inner) |
+                   movesInDirection<9>(player, inner) |
+                   movesInDirection<-9>(player, inner);
+  return moves & ~(player | opponent);
+}
+
+uint64_t flipsScalarMask(uint64_t move, uint64_t player, uint64_t opponent) {
+  const uint64_t inner = opponent & INNER_FILES;
+  return flipsInDirection<1>(move, player, inner) |
+         flipsInDirection<-1>(move, player, inner) |
+         flipsInDirection<8>(move, player, opponent) |
+         flipsInDirection<-8>(move, player, opponent) |
+         flipsInDirection<7>(move, player, inner) |
+         flipsInDirection<-7>(move, player, inner) |
+         flipsInDirection<9>(move, player, inner) |
+         flipsInDirection<-9>(move, player, inner);
+}
+
+uint64_t flipsScalar(int bit, uint64_t player, uint64_t opponent) {
+  return flipsScalarMask(1ULL << bit, player, opponent);
+}
+
+void legalMovesBatchScalar(const uint64_t *player, const uint64_t *opponent,
+                           uint64_t *moves, int count) {
+  for (int i = 0; i < count; ++i)
+    moves[i] = legalMovesScalar(player[i], opponent[i]);
+}
+
+void flipsBatchScalar(const uint64_t *move, const uint64_t *player,
+                      const uint64_t *opponent, uint64_t *flips, int count) {
+  for (int i = 0; i < count; ++i)
+    flips[i] = flipsScalarMask(move[i], player[i], opponent[i]);
+}
+
+#ifdef BITBOARD_AVX2_KERNELS
+// AVX2 versions of the same fills. One 256-bit register holds the four line
+// orientations (E/W, N/S, NE/SW, NW/SE); left and right variable shifts
+// cover the two directions of each, so the 8 scalar fills become 2.
+
+__attribute__((target("avx2"))) inline uint64_t orLanes(__m256i v) {
+  __m128i x = _mm_or_si128(_mm256_castsi256_si128(v),
+                           _mm256_extracti128_si256(v, 1));
+  return static_cast<uint64_t>(_mm_cvtsi128_si64(x)) |
+         static_cast<uint64_t>(_mm_extract_epi64(x, 1));
+}
+
+__attribute__((target("avx2"))) inline __m256i
+opponentLanes(uint64_t opponent) {
+  const __m256i fileMasks =
+      _mm256_set_epi64x(static_cast<long long>(INNER_FILES),
+                        static_cast<long long>(INNER_FILES), -1LL,
+                        static_cast<long long>(INNER_FILES));
+  return _mm256_and_si256(
+      _mm256_set1_epi64x(static_cast<long long>(opponent)), fileMasks);
+}
+
+__attribute__((target("avx2"))) uint64_t legalMovesAvx2(uint64_t player,
+                                                         uint64_t opponent) {
+  const __m256i shifts = _mm256_set_epi64x(9, 7, 8, 1);
+  const __m256i pp = _mm256_set1_epi64x(static_cast<long long>(player));
+  const __m256i oo = opponentLanes(opponent);
+  __m256i left = _mm256_and_si256(oo, _mm256_sllv_epi64(pp, shifts));
+  __m256i right = _mm256_and_si256(oo, _mm256_srlv_epi64(pp, shifts));
+  for (int i = 0; i < 5; ++i) {
+    left = _mm256_or_si256(
+        left, _mm256_and_si256(oo, _mm256_sllv_epi64(left, shifts)));
+    right = _mm256_or_si256(
+        right, _mm256_and_si256(oo, _mm256_srlv_epi64(right, shifts)));
   }
-  return flipped;
+  __m256i moves = _mm256_or_si256(_mm256_sllv_epi64(left, shifts),
+                                  _mm256_srlv_epi64(right, shifts));
+  return orLanes(moves) & ~(player | opponent);
+}
+
+__attribute__((target("avx2"))) uint64_t flipsAvx2(int bit, uint64_t player,
+                                                    uint64_t opponent) {
+  const __m256i shifts = _mm256_set_epi64x(9, 7, 8, 1);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i pp = _mm256_set1_epi64x(static_cast<long long>(player));
+  const __m256i oo = opponentLanes(opponent);
+  const __m256i move = _mm256_set1_epi64x(static_cast<long long>(1ULL << bit));
+  __m256i left = _mm256_and_si256(oo, _mm256_sllv_epi64(move, shifts));
+  __m256i right = _mm256_and_si256(oo, _mm256_srlv_epi64(move, shifts));
+  for (int i = 0; i < 5; ++i) {
+    left = _mm256_or_si256(
+        left, _mm256_and_si256(oo, _mm256_sllv_epi64(left, shifts)));
+    right = _mm256_or_si256(
+        right, _mm256_and_si256(oo, _mm256_srlv_epi64(right, shifts)));
+  }
+  // Drop the lanes whose run is not closed by a player disc
+  __m256i closedLeft = _mm256_and_si256(pp, _mm256_sllv_epi64(left, shifts));
+  __m256i closedRight = _mm256_and_si256(pp, _mm256_srlv_epi64(right, shifts));
+  left = _mm256_andnot_si256(_mm256_cmpeq_epi64(closedLeft, zero), left);
+  right = _mm256_andnot_si256(_mm256_cmpeq_epi64(closedRight, zero), right);
+  return orLanes(_mm256_or_si256(left, right));
+}
+
+// Batched kernels run the scalar algorithm on four independent positions at
+// once, one per 64-bit lane, with the 8 directions unrolled.
+__attribute__((target("avx2"))) inline __m256i loadLanes(const uint64_t *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+template <int Shift>
+__attribute__((target("avx2"))) inline __m256i shiftLanes(__m256i x) {
+  if constexpr (Shift > 0)
+    return _mm256_slli_epi64(x, Shift);
+  else
+    return _mm256_srli_epi64(x, -Shift);
+}
+
+template <int Shift>
+__attribute__((target("avx2"))) inline __m256i fillLanes(__m256i from,
+                                                          __m256i opp) {
+  __m256i run = _mm256_and_si256(opp, shiftLanes<Shift>(from));
+  for (int i = 0; i < 5; ++i)
+    run = _mm256_or_si256(run, _mm256_and_si256(opp, shiftLanes<Shift>(run)));
+  return run;
+}
+
+template <int Shift>
+__attribute__((target("avx2"))) inline __m256i movesLanes(__m256i player,
+                                                           __m256i opp) {
+  return shiftLanes<Shift>(fillLanes<Shift>(player, opp));
+}
+
+template <int Shift>
+__attribute__((target("avx2"))) inline __m256i
+flipsLanes(__m256i move, __m256i player, __m256i opp) {
+  __m256i run = fillLanes<Shift>(move, opp);
+  __m256i closed = _mm256_and_si256(player, shiftLanes<Shift>(run));
+  return _mm256_andnot_si256(
+      _mm256_cmpeq_epi64(closed, _mm256_setzero_si256()), run);
+}
+
+__attribute__((target("avx2"))) void
+legalMovesBatchAvx2(const uint64_t *player, const uint64_t *opponent,
+                    uint64_t *moves, int count) {
+  const __m256i innerFiles =
+      _mm256_set1_epi64x(static_cast<long long>(INNER_FILES));
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256i pp = loadLanes(player + i);
+    __m256i oo = loadLanes(opponent + i);
+    __m256i inner = _mm256_and_si256(oo, innerFiles);
+    __m256i m = _mm256_or_si256(
+        _mm256_or_si256(_mm256_or_si256(movesLanes<1>(pp, inner),
+                                        movesLanes<-1>(pp, inner)),
+                        _mm256_or_si256(movesLanes<8>(pp, oo),
+                                        movesLanes<-8>(pp, oo))),
+        _mm256_or_si256(_mm256_or_si256(movesLanes<7>(pp, inner),
+                                        movesLanes<-7>(pp, inner)),
+                        _mm256_or_si256(movesLanes<9>(pp, inner),
+                                        movesLanes<-9>(pp, inner))));
+    m = _mm256_andnot_si256(_mm256_or_si256(pp, oo), m);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(moves + i), m);
+  }
+  legalMovesBatchScalar(player + i, opponent + i, moves + i, count - i);
+}
+
+__attribute__((target("avx2"))) void
+flipsBatchAvx2(const uint64_t *move, const uint64_t *player,
+               const uint64_t *opponent, uint64_t *flips, int count) {
+  const __m256i innerFiles =
+      _mm256_set1_epi64x(static_cast<long long>(INNER_FILES));
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256i mv = loadLanes(move + i);
+    __m256i pp = loadLanes(player + i);
+    __m256i oo = loadLanes(opponent + i);
+    __m256i inner = _mm256_and_si256(oo, innerFiles);
+    __m256i f = _mm256_or_si256(
+        _mm256_or_si256(_mm256_or_si256(flipsLanes<1>(mv, pp, inner),
+                                        flipsLanes<-1>(mv, pp, inner)),
+                        _mm256_or_si256(flipsLanes<8>(mv, pp, oo),
+                                        flipsLanes<-8>(mv, pp, oo))),
+        _mm256_or_si256(_mm256_or_si256(flipsLanes<7>(mv, pp, inner),
+                                        flipsLanes<-7>(mv, pp, inner)),
+                        _mm256_or_si256(flipsLanes<9>(mv, pp, inner),
+                                        flipsLanes<-9>(mv, pp, inner))));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(flips + i), f);
+  }
+  flipsBatchScalar(move + i, player + i, opponent + i, flips + i, count - i);
+}
+#endif
+
+// Kernel dispatch. The pointers start on resolvers that pick the backend from
+// the CPU features on first use, so no static initialisation order issues.
+using MovesKernel = uint64_t (*)(uint64_t, uint64_t);
+using FlipsKernel = uint64_t (*)(int, uint64_t, uint64_t);
+using MovesBatchKernel = void (*)(const uint64_t *, const uint64_t *,
+                                  uint64_t *, int);
+using FlipsBatchKernel = void (*)(const uint64_t *, const uint64_t *,
+                                  const uint64_t *, uint64_t *, int);
+
+uint64_t resolveMoves(uint64_t player, uint64_t opponent);
+uint64_t resolveFlips(int bit, uint64_t player, uint64_t opponent);
+void resolveMovesBatch(const uint64_t *player, const uint64_t *opponent,
+                       uint64_t *moves, int count);
+void resolveFlipsBatch(const uint64_t *move, const uint64_t *player,
+                       const uint64_t *opponent, uint64_t *flips, int count);
+
+std::atomic<MovesKernel> movesKernel{&resolveMoves};
+std::atomic<FlipsKernel> flipsKernel{&resolveFlips};
+std::atomic<MovesBatchKernel> movesBatchKernel{&resolveMovesBatch};
+std::atomic<FlipsBatchKernel> flipsBatchKernel{&resolveFlipsBatch};
+std::atomic<BitBoard::Backend> activeBackend{BitBoard::Backend::SCALAR};
+
+BitBoard::Backend detectBackend() {
+#ifdef BITBOARD_AVX2_KERNELS
+  if (__builtin_cpu_supports("avx2"))
+    return BitBoard::Backend::AVX2;
+#endif
+  return BitBoard::Backend::SCALAR;
+}
+
+uint64_t resolveMoves(uint64_t player, uint64_t opponent) {
+  BitBoard::setBackend(detectBackend());
+  return movesKernel.load(std::memory_order_relaxed)(player, opponent);
+}
+
+uint64_t resolveFlips(int bit, uint64_t player, uint64_t opponent) {
+  BitBoard::setBackend(detectBackend());
+  return flipsKernel.load(std::memory_order_relaxed)(bit, player, opponent);
+}
+
+void resolveMovesBatch(const uint64_t *player, const uint64_t *opponent,
+                       uint64_t *moves, int count) {
+  BitBoard::setBackend(detectBackend());
+  movesBatchKernel.load(std::memory_order_relaxed)(player, opponent, moves,
+                                                   count);
+}
+
+void resolveFlipsBatch(const uint64_t *move, const uint64_t *player,
+                       const uint64_t *opponent, uint64_t *flips, int count) {
+  BitBoard::setBackend(detectBackend());
+  flipsBatchKernel.load(std::memory_order_relaxed)(move, player, opponent,
+                                                   flips, count);
+}
+
+} // namespace
+
+bool BitBoard::isBackendSupported(Backend backend) {
+  switch (backend) {
+  case Backend::SCALAR:
+    return true;
+  case Backend::AVX2:
+#ifdef BITBOARD_AVX2_KERNELS
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
+bool BitBoard::setBackend(Backend backend) {
+  if (!isBackendSupported(backend))
+    return false;
+  MovesKernel moves = &legalMovesScalar;
+  FlipsKernel flips = &flipsScalar;
+  MovesBatchKernel movesBatch = &legalMovesBatchScalar;
+  FlipsBatchKernel flipsBatch = &flipsBatchScalar;
+#ifdef BITBOARD_AVX2_KERNELS
+  if (backend == Backend::AVX2) {
+    moves = &legalMovesAvx2;
+    flips = &flipsAvx2;
+    movesBatch = &legalMovesBatchAvx2;
+    flipsBatch = &flipsBatchAvx2;
+  }
+#endif
+  movesKernel.store(moves, std::memory_order_relaxed);
+  flipsKernel.store(flips, std::memory_order_relaxed);
+  movesBatchKernel.store(movesBatch, std::memory_order_relaxed);
+  flipsBatchKernel.store(flipsBatch, std::memory_order_relaxed);
+  activeBackend.store(backend, std::memory_order_relaxed);
+  return true;
+}
+
+BitBoard::Backend BitBoard::getBackend() {
+  if (movesKernel.load(std::memory_order_relaxed) == &resolveMoves)
+    setBackend(detectBackend());
+  return activeBackend.load(std::memory_order_relaxed);
+}
+
+uint64_t BitBoard::legalMovesMask(bool isBlack) const {
+  return legalMovesMask(getPlayerBoard(isBlack), getOpponentBoard(isBlack));
+}
+
+uint64_t BitBoard::legalMovesMask(uint64_t player, uint64_t opponent) {
+  return movesKernel.load(std::memory_order_relaxed)(player, opponent);
+}
+
+uint64_t BitBoard::flipsMask(int bit, bool isBlack) const {
+  return flipsMask(bit, getPlayerBoard(isBlack), getOpponentBoard(isBlack));
+}
+
+uint64_t BitBoard::flipsMask(int bit, uint64_t player, uint64_t opponent) {
+  return flipsKernel.load(std::memory_order_relaxed)(bit, player, opponent);
+}
+
+void BitBoard::legalMovesMaskBatch(const uint64_t *player,
+                                   const uint64_t *opponent, uint64_t *moves,
+                                   int count) {
+  movesBatchKernel.load(std::memory_order_relaxed)(player, opponent, moves,
+                                                   count);
+}
+
+void BitBoard::flipsMaskBatch(const uint64_t *move, const uint64_t *player,
+                              const uint64_t *opponent, uint64_t *flips,
+                              int count) {
+  flipsBatchKernel.load(std::memory_order_relaxed)(move, player, opponent,
+                                                   flips, count);
+}
+
+uint64_t BitBoard::getFlippedBitboard(int row, int col, bool isBlack) const {
+  return flipsMask(positionToBit(row, col), isBlack);
 }
 
 std::vector<std::pair<int, int>> BitBoard::getFlippedDiscs(int row, int col,
@@ -204,57 +534,86 @@ std::vector<std::pair<int, int>> BitBoard::getFlippedDiscs(int row, int col,
 }
 
 bool BitBoard::makeMove(int row, int col, bool isBlack) {
-  if (!isValidMove(row, col, isBlack)) {
+  if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE) {
     return false;
   }
-  uint64_t moveMask = positionToMask(row, col);
-  uint64_t flipped = getFlippedBitboard(row, col, isBlack);
-  auto [pr, pc] = bitToPosition(__builtin_ctzll(moveMask));
-  if (isBlack) {
-    hash_ ^= zobristTable[pr][pc][0];
-  } else {
-    hash_ ^= zobristTable[pr][pc][1];
+  int bit = positionToBit(row, col);
+  if ((blackBoard | whiteBoard) & (1ULL << bit)) {
+    return false;
   }
-  uint64_t tmp = flipped;
-  while (tmp) {
-    int bit = __builtin_ctzll(tmp);
-    tmp &= tmp - 1;
-    auto [r, c] = bitToPosition(bit);
-    if (isBlack) {
-      hash_ ^= zobristTable[r][c][1];
-      hash_ ^= zobristTable[r][c][0];
-    } else {
-      hash_ ^= zobristTable[r][c][0];
-      hash_ ^= zobristTable[r][c][1];
-    }
+  uint64_t flipped = flipsMask(bit, isBlack);
+  if (!flipped) {
+    return false;
   }
+  applyMove(bit, flipped, isBlack);
+  return true;
+}
+
+uint64_t BitBoard::makeMoveUnchecked(int bit, bool isBlack) {
+  uint64_t flipped = flipsMask(bit, isBlack);
+  applyMove(bit, flipped, isBlack);
+  return flipped;
+}
+
+bool BitBoard::makeMove(int bit, bool isBlack, Undo &undo) {
+  if ((blackBoard | whiteBoard) & (1ULL << bit)) {
+    return false;
+  }
+  uint64_t flipped = flipsMask(bit, isBlack);
+  if (!flipped) {
+    return false;
+  }
+  undo.flips = flipped;
+  undo.hash = hash_;
+  undo.square = bit;
+  undo.isBlack = isBlack;
+  applyMove(bit, flipped, isBlack);
+  return true;
+}
+
+void BitBoard::unmakeMove(const Undo &undo) {
+  uint64_t moveMask = 1ULL << undo.square;
+  if (undo.isBlack) {
+    blackBoard &= ~(moveMask | undo.flips);
+    whiteBoard |= undo.flips;
+  } else {
+    whiteBoard &= ~(moveMask | undo.flips);
+    blackBoard |= undo.flips;
+  }
+  hash_ = undo.hash;
+}
+
+void BitBoard::applyMove(int bit, uint64_t flipped, bool isBlack) {
+  uint64_t moveMask = 1ULL << bit;
+  hash_ ^= zobristTable[bit >> 3][bit & 7][isBlack ? 0 : 1];
+  hash_ ^= flipHashDelta(flipped);
   if (isBlack) {
-    blackBoard |= moveMask;
-    blackBoard |= flipped;
+    blackBoard |= moveMask | flipped;
     whiteBoard &= ~flipped;
   } else {
-    whiteBoard |= moveMask;
-    whiteBoard |= flipped;
+    whiteBoard |= moveMask | flipped;
     blackBoard &= ~flipped;
   }
-  return true;
+}
+
+uint64_t BitBoard::flipHashDelta(uint64_t flipped) {
+  return zobristFlipFold[0][flipped & 0xff] ^
+         zobristFlipFold[1][(flipped >> 8) & 0xff] ^
+         zobristFlipFold[2][(flipped >> 16) & 0xff] ^
+         zobristFlipFold[3][(flipped >> 24) & 0xff] ^
+         zobristFlipFold[4][(flipped >> 32) & 0xff] ^
+         zobristFlipFold[5][(flipped >> 40) & 0xff] ^
+         zobristFlipFold[6][(flipped >> 48) & 0xff] ^
+         zobristFlipFold[7][flipped >> 56];
 }
 
 bool BitBoard::hasValidMoves(bool isBlack) const {
-  if (isFull())
-    return false;
-  for (int r = 0; r < BOARD_SIZE; ++r) {
-    for (int c = 0; c < BOARD_SIZE; ++c) {
-      if (isValidMove(r, c, isBlack)) {
-        return true;
-      }
-    }
-  }
-  return false;
+  return legalMovesMask(isBlack) != 0;
 }
 
 bool BitBoard::isGameOver() const {
-  return !hasValidMoves(true) && !hasValidMoves(false);
+  return (legalMovesMask(blackBoard, whiteBoard) |
+          legalMovesMask(whiteBoard, blackBoard)) == 0;
 }
 
 bool BitBoard::isFull() const {
@@ -316,6 +675,24 @@ void BitBoard::initializeZobrist(uint64_t seed) {
       }
     }
     zobristBlackToMoveKey = splitmix64(s);
+    for (int r = 0; r < 8; ++r) {
+      for (int b = 0; b < 256; ++b) {
+        uint64_t h = 0;
+        for (int c = 0; c < 8; ++c) {
+          if (b & (1 << c))
+            h ^= zobristTable[r][c][0] ^ zobristTable[r][c][1];
+        }
+        zobristFlipFold[r][b] = h;
+        for (int p = 0; p < 2; ++p) {
+          uint64_t place = 0;
+          for (int c = 0; c < 8; ++c) {
+            if (b & (1 << c))
+              place ^= zobristTable[r][c][p];
+          }
+          zobristPlaceFold[p][r][b] = place;
+        }
+      }
+    }
     zobristInitialised = true;
     return true;
   }();
@@ -345,31 +722,64 @@ uint64_t BitBoard::getZobristHash(bool blackToMove) const {
   return h;
 }
 
+uint64_t BitBoard::getZobristHashAfter(int bit, uint64_t flipped,
+                                       bool isBlack) const {
+  return getZobristHash() ^ zobristTable[bit >> 3][bit & 7][isBlack ? 0 : 1] ^
+         flipHashDelta(flipped);
+}
+
+uint64_t BitBoard::getZobristHashAfter(int bit, uint64_t flipped, bool isBlack,
+                                       bool blackToMove) const {
+  uint64_t h = getZobristHashAfter(bit, flipped, isBlack);
+  if (blackToMove)
+    h ^= zobristBlackToMoveKey;
+  return h;
+}
+
 uint64_t BitBoard::getCanonicalZobristHash() const {
-  BitBoard canonical = toCanonical();
-  return canonical.getZobristHash();
+  initializeZobrist();
+  const auto sb = symmetries(blackBoard);
+  const auto sw = symmetries(whiteBoard);
+  int i = canonicalIndex(sb, sw);
+  return computeHash(sb[i], sw[i]);
 }
 
 BitBoard BitBoard::toCanonical() const {
-  BitBoard candidates[8];
-  candidates[0] = *this;
-  candidates[1] = this->rot90();
-  candidates[2] = this->rot180();
-  candidates[3] = this->rot270();
-  candidates[4] = this->mirrorHorizontal();
-  candidates[5] = this->mirrorVertical();
-  candidates[6] = this->mirrorDiag();
-  candidates[7] = this->mirrorAntiDiag();
-
-  BitBoard best = candidates[0];
+  const auto sb = symmetries(blackBoard);
+  const auto sw = symmetries(whiteBoard);
+  int i = canonicalIndex(sb, sw);
+  return {sb[i], sw[i]};
+}
+
+std::array<uint64_t, 8> BitBoard::symmetries(uint64_t x) {
+  // Every symmetry is one of the four row/column reflections, optionally
+  // followed by a transpose: rot90 = D.H, rot270 = D.V, antiDiag = D.V.H.
+  const uint64_t h = flipHorizontal(x);
+  const uint64_t v = flipVertical(x);
+  const uint64_t hv = flipVertical(h);
+  return {x, flipDiagonal(h), hv, flipDiagonal(v),
+          h, v, flipDiagonal(x), flipDiagonal(hv)};
+}
+
+int BitBoard::canonicalIndex(const std::array<uint64_t, 8> &sb,
+                             const std::array<uint64_t, 8> &sw) {
+  int best = 0;
   for (int i = 1; i < 8; ++i) {
-    if (candidates[i] < best) {
-      best = candidates[i];
-    }
+    if (sb[i] < sb[best] || (sb[i] == sb[best] && sw[i] < sw[best]))
+      best = i;
   }
   return best;
 }
 
+uint64_t BitBoard::computeHash(uint64_t black, uint64_t white) {
+  uint64_t h = 0;
+  for (int r = 0; r < 8; ++r) {
+    h ^= zobristPlaceFold[0][r][(black >> (8 * r)) & 0xff];
+    h ^= zobristPlaceFold[1][r][(white >> (8 * r)) & 0xff];
+  }
+  return h;
+}
+
 BitBoard BitBoard::rot90() const {
   return {flipDiagonal(flipHorizontal(blackBoard)),
           flipDiagonal(flipHorizontal(whiteBoard))};
@@ -401,57 +811,200 @@ BitBoard BitBoard::mirrorAntiDiag() const {
   return {flipAntiDiagonal(blackBoard), flipAntiDiagonal(whiteBoard)};
 }
 
-uint64_t BitBoard::getStableMaskForPlayerBitwise(bool isBlack) const {
-  const uint64_t player = getPlayerBoard(isBlack);
-
-  // Masks to prevent wraparound during bit shifts
-  const uint64_t NOT_LEFT = 0xfefefefefefefefeULL;
-  const uint64_t NOT_RIGHT = 0x7f7f7f7f7f7f7f7fULL;
-  const uint64_t NOT_TOP = 0xffffffffffffff00ULL;
-  const uint64_t NOT_BOTTOM = 0x00ffffffffffffffULL;
-
-  // Initial stable positions (corners)
-  uint64_t stable = 0;
-  if (player & positionToMask(0, 0))
-    stable |= positionToMask(0, 0);
-  if (player & positionToMask(0, 7))
-    stable |= positionToMask(0, 7);
-  if (player & positionToMask(7, 0))
-    stable |= positionToMask(7, 0);
-  if (player & positionToMask(7, 7))
-    stable |= positionToMask(7, 7);
-
-  uint64_t prev = 0;
-
-  while (stable != prev) {
-    prev = stable;
-
-    // All player stones not yet marked as stable
-    uint64_t candidates = player & ~stable;
-
-    // Build masks of stable directions
-    uint64_t north = ((stable << 8) & NOT_TOP);
-    uint64_t south = ((stable >> 8) & NOT_BOTTOM);
-    uint64_t east = ((stable >> 1) & NOT_RIGHT);
-    uint64_t west = ((stable << 1) & NOT_LEFT);
-    uint64_t ne = ((stable << 7) & NOT_TOP & NOT_RIGHT);
-    uint64_t nw = ((stable << 9) & NOT_TOP & NOT_LEFT);
-    uint64_t se = ((stable >> 9) & NOT_BOTTOM & NOT_RIGHT);
-    uint64_t sw = ((stable >> 7) & NOT_BOTTOM & NOT_LEFT);
-
-    // Keep only candidates that are fully surrounded in all directions
-    uint64_t surrounded = north & south & east & west & ne & nw & se & sw;
-
-    // Filter to only player's pieces
-    surrounded &= candidates;
-
-    // Add to stable set
-    stable |= surrounded;
+namespace {
+
+constexpr uint64_t FILE_A = 0x0101010101010101ULL;
+constexpr uint64_t INTERIOR = 0x007e7e7e7e7e7e00ULL;
+
+// Edge stability tables. An edge line is an 8-cell row of base-3 digits (0
+// empty, 1 player, 2 opponent) and stable[index] holds the player's discs on
+// it that no sequence of edge moves can flip. Discs on an edge can only be
+// flipped along that edge, so the table is exact for edge squares.
+struct EdgeTables {
+  std::array<uint16_t, 256> base3;
+  std::array<uint8_t, 6561> stable;
+  // columnBits[b]: byte b spread onto file A, bit i going to row i
+  std::array<uint64_t, 256> columnBits;
+
+  EdgeTables() {
+    for (int b = 0; b < 256; ++b) {
+      int index = 0;
+      uint64_t column = 0;
+      for (int i = 7; i >= 0; --i) {
+        index = index * 3 + ((b >> i) & 1);
+        if (b & (1 << i))
+          column |= 1ULL << (8 * i);
+      }
+      base3[b] = static_cast<uint16_t>(index);
+      columnBits[b] = column;
+    }
+    // A disc is stable if it survives every move from here on, so each
+    // entry is the intersection over its children. Children hold more
+    // discs, so filling lines from full to empty sees them first.
+    for (int discs = 8; discs >= 0; --discs) {
+      for (int occupied = 0; occupied < 256; ++occupied) {
+        if (__builtin_popcount(occupied) != discs)
+          continue;
+        // Enumerate player subsets of the occupied cells
+        for (int player = occupied;; player = (player - 1) & occupied) {
+          int opponent = occupied & ~player;
+          stable[index(player, opponent)] =
+              static_cast<uint8_t>(solve(player, opponent));
+          if (player == 0)
+            break;
+        }
+      }
+    }
+  }
+
+  int index(int player, int opponent) const {
+    return base3[player] + 2 * base3[opponent];
+  }
+
+  // Discs flipped along the line when `player` plays on square x
+  static int lineFlips(int x, int player, int opponent) {
+    int flips = 0;
+    int run = 0;
+    int y = x - 1;
+    for (; y >= 0 && (opponent & (1 << y)); --y)
+      run |= 1 << y;
+    if (y >= 0 && (player & (1 << y)))
+      flips |= run;
+    run = 0;
+    y = x + 1;
+    for (; y < 8 && (opponent & (1 << y)); ++y)
+      run |= 1 << y;
+    if (y < 8 && (player & (1 << y)))
+      flips |= run;
+    return flips;
   }
 
+  int solve(int player, int opponent) const {
+    int result = player;
+    int empty = ~(player | opponent) & 0xff;
+    for (int x = 0; x < 8 && result; ++x) {
+      if (!(empty & (1 << x)))
+        continue;
+      // Any empty edge square may become playable through the other
+      // directions, even when it flips nothing along the edge itself.
+      int f = lineFlips(x, player, opponent);
+      result &= stable[index(player | f | (1 << x), opponent & ~f)];
+      f = lineFlips(x, opponent, player);
+      result &= stable[index(player & ~f, opponent | f | (1 << x))];
+    }
+    return result;
+  }
+};
+
+const EdgeTables &edgeTables() {
+  static const EdgeTables tables;
+  return tables;
+}
+
+// Gathers one file into a byte, row i going to bit i
+uint8_t fileToByte(uint64_t x, int file) {
+  uint64_t column = (x >> file) & FILE_A;
+  return static_cast<uint8_t>((column * 0x0102040810204080ULL) >> 56);
+}
+
+// Squares whose line in each orientation is completely filled; no disc can
+// be flipped along a full line. Each fill ANDs a square with its neighbours
+// at distance 1, 2 and 4 along the line, treating off-board as filled.
+struct FullLines {
+  uint64_t horizontal;
+  uint64_t vertical;
+  uint64_t diagonal;
+  uint64_t antiDiagonal;
+};
+
+FullLines fullLines(uint64_t occupied) {
+  FullLines full;
+
+  uint64_t h = occupied & (occupied >> 1);
+  h &= h >> 2;
+  h &= h >> 4;
+  full.horizontal = (h & FILE_A) * 0xff;
+
+  uint64_t v = occupied & ((occupied >> 8) | (occupied << 56));
+  v &= (v >> 16) | (v << 48);
+  v &= (v >> 32) | (v << 32);
+  full.vertical = v;
+
+  uint64_t l9 = occupied, r9 = occupied;
+  l9 &= 0xff80808080808080ULL | (l9 >> 9);
+  r9 &= 0x01010101010101ffULL | (r9 << 9);
+  l9 &= 0xffffc0c0c0c0c0c0ULL | (l9 >> 18);
+  r9 &= 0x030303030303ffffULL | (r9 << 18);
+  l9 &= 0xfffffffff0f0f0f0ULL | (l9 >> 36);
+  r9 &= 0x0f0f0f0fffffffffULL | (r9 << 36);
+  full.diagonal = l9 & r9;
+
+  uint64_t l7 = occupied, r7 = occupied;
+  l7 &= 0xff01010101010101ULL | (l7 >> 7);
+  r7 &= 0x80808080808080ffULL | (r7 << 7);
+  l7 &= 0xffff030303030303ULL | (l7 >> 14);
+  r7 &= 0xc0c0c0c0c0c0ffffULL | (r7 << 14);
+  l7 &= 0xffffffff0f0f0f0fULL | (l7 >> 28);
+  r7 &= 0xf0f0f0f0ffffffffULL | (r7 << 28);
+  full.antiDiagonal = l7 & r7;
+  return full;
+}
+
+uint64_t edgeStable(uint64_t player, uint64_t opponent) {
+  const EdgeTables &t = edgeTables();
+  auto lookup = [&t](uint8_t p, uint8_t o) -> uint64_t {
+    return t.stable[t.index(p, o)];
+  };
+  uint64_t stable = lookup(player & 0xff, opponent & 0xff);
+  stable |= lookup(player >> 56, opponent >> 56) << 56;
+  for (int file : {0, 7}) {
+    uint8_t p = fileToByte(player, file);
+    uint8_t o = fileToByte(opponent, file);
+    stable |= t.columnBits[lookup(p, o)] << file;
+  }
   return stable;
 }
 
+uint64_t stableDiscs(uint64_t player, uint64_t opponent,
+                     const FullLines &full) {
+  uint64_t stable = edgeStable(player, opponent);
+
+  // An interior disc is stable once, along each of the four line
+  // orientations, its line is full or one of its neighbours on that line is
+  // a stable disc of the same colour (any flip would have to flip it too).
+  const uint64_t interior = player & INTERIOR;
+  uint64_t previous;
+  do {
+    previous = stable;
+    uint64_t h = (stable >> 1) | (stable << 1) | full.horizontal;
+    uint64_t v = (stable >> 8) | (stable << 8) | full.vertical;
+    uint64_t d = (stable >> 9) | (stable << 9) | full.diagonal;
+    uint64_t a = (stable >> 7) | (stable << 7) | full.antiDiagonal;
+    stable |= h & v & d & a & interior;
+  } while (stable != previous);
+  return stable;
+}
+
+} // namespace
+
+uint64_t BitBoard::stableDiscs(uint64_t player, uint64_t opponent) {
+  return ::stableDiscs(player, opponent, fullLines(player | opponent));
+}
+
+uint64_t BitBoard::getStableMask() const {
+  const FullLines full = fullLines(blackBoard | whiteBoard);
+  return ::stableDiscs(blackBoard, whiteBoard, full) |
+         ::stableDiscs(whiteBoard, blackBoard, full);
+}
+
+uint64_t BitBoard::getStableDiscs(bool isBlack) const {
+  return stableDiscs(getPlayerBoard(isBlack), getOpponentBoard(isBlack));
+}
+
+uint64_t BitBoard::getStableMaskForPlayerBitwise(bool isBlack) const {
+  return getStableDiscs(isBlack);
+}
+
 bool BitBoard::isCornerControlled(int r, int c, bool isBlack) const {
   int corner_r = (r < 4) ? 0 : 7;
   int corner_c = (c < 4) ? 0 : 7;
@@ -29,7 +29,7 @@ ConsoleGame::ConsoleGame()
       selectedAIAgent(AIAgentType::BITBOARD),
       selectedOpponentAIAgent(AIAgentType::BITBOARD),
       currentPlayer(CellState::BLACK), gameRunning(false), passCount(0),
-      aiTimeLimit(std::chrono::milliseconds(1000)) {}
+      aiTimeLimit(std::chrono::milliseconds(1000)), aiPondering(false) {}
 
 ConsoleGame::~ConsoleGame() = default;
 
@@ -166,6 +166,9 @@ void ConsoleGame::configureAISettings() {
       "Enter new time limit in milliseconds (100-10000): ", 100, 10000);
   aiTimeLimit = std::chrono::milliseconds(timeLimit);
 
+  aiPondering =
+      getYesNoInput("Let the AI think on the opponent's time? (y/n): ");
+
   std::cout << std::endl;
 }
 
@@ -187,6 +190,7 @@ void ConsoleGame::startGame() {
         handlePass();
       } else {
         board.makeMove(move.first, move.second, currentPlayer);
+        notifyMoveMade(move.first, move.second, currentPlayer);
         passCount = 0;
         switchPlayer();
       }
@@ -216,6 +220,7 @@ void ConsoleGame::startGame() {
               handlePass();
             } else {
               board.makeMove(move.first, move.second, currentPlayer);
+              notifyMoveMade(move.first, move.second, currentPlayer);
               passCount = 0;
               switchPlayer();
             }
@@ -231,6 +236,10 @@ void ConsoleGame::startGame() {
     // Check for game over
     if (passCount >= 2 || board.isFull()) {
       gameRunning = false;
+      for (AIAgentBase *agent : {aiAgent.get(), opponentAIAgent.get()}) {
+        if (agent)
+          agent->stopPondering();
+      }
       displayGameOver();
     }
   }
@@ -251,6 +260,21 @@ void ConsoleGame::initializeGame() {
     opponentAIAgent.reset(
         createAIAgent(selectedOpponentAIAgent, "Opponent AI"));
   }
+
+  for (AIAgentBase *agent : {aiAgent.get(), opponentAIAgent.get()}) {
+    if (agent) {
+      agent->setPonderingAllowed(aiPondering);
+      agent->onGameStart();
+    }
+  }
+}
+
+// Lets pondering agents keep or drop their background search
+void ConsoleGame::notifyMoveMade(int row, int col, CellState player) {
+  for (AIAgentBase *agent : {aiAgent.get(), opponentAIAgent.get()}) {
+    if (agent)
+      agent->onMoveMade(row, col, player);
+  }
 }
 
 void ConsoleGame::displayBoard() {
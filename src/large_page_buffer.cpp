@@ -0,0 +1,165 @@
+#include "large_page_buffer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <cstdio>
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+// Heap blocks are aligned to cache lines, as the tables' buckets are
+constexpr size_t HEAP_ALIGNMENT = 64;
+
+size_t roundUp(size_t bytes, size_t multiple) {
+  return (bytes + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+LargePageBuffer::LargePageBuffer(size_t bytes, bool faultIn) : bytes_(bytes) {
+#ifdef __linux__
+  if (bytes >= HUGE_PAGE_SIZE) {
+    size_t length = roundUp(bytes, HUGE_PAGE_SIZE);
+    void *p = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      data_ = p;
+      mappedBytes_ = length;
+      backing_ = Backing::EXPLICIT_HUGE_PAGES;
+    }
+
+    // Over-map by a page to cut a 2 MB aligned range out of it, since
+    // transparent huge pages only back aligned 2 MB ranges
+    if (data_ == nullptr)
+      p = mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data_ == nullptr && p != MAP_FAILED) {
+      uintptr_t start = reinterpret_cast<uintptr_t>(p);
+      uintptr_t aligned = roundUp(start, HUGE_PAGE_SIZE);
+      if (aligned > start)
+        munmap(p, aligned - start);
+      size_t tail = HUGE_PAGE_SIZE - (aligned - start);
+      if (tail > 0)
+        munmap(reinterpret_cast<void *>(aligned + length), tail);
+      data_ = reinterpret_cast<void *>(aligned);
+      mappedBytes_ = length;
+      backing_ = Backing::TRANSPARENT_HUGE_PAGES;
+#ifdef MADV_HUGEPAGE
+      madvise(data_, mappedBytes_, MADV_HUGEPAGE);
+#endif
+    }
+  }
+  if (data_ != nullptr) {
+    if (faultIn)
+      std::memset(data_, 0, mappedBytes_);
+    return;
+  }
+#endif
+  data_ = std::aligned_alloc(HEAP_ALIGNMENT, roundUp(bytes, HEAP_ALIGNMENT));
+  if (data_ == nullptr)
+    throw std::bad_alloc();
+  std::memset(data_, 0, bytes);
+}
+
+LargePageBuffer::~LargePageBuffer() {
+#ifdef __linux__
+  if (backing_ != Backing::HEAP) {
+    munmap(data_, mappedBytes_);
+    return;
+  }
+#endif
+  std::free(data_);
+}
+
+void LargePageBuffer::reset(int threads) {
+  size_t length = bytes_;
+  // Pages handed back come back zeroed by the kernel on their next fault,
+  // so one write per page places them without zeroing them twice
+  bool dropped = false;
+#ifdef __linux__
+  // Pages reserved for explicit huge pages only accept this on recent
+  // kernels; they are zeroed in place otherwise
+  if (backing_ != Backing::HEAP) {
+    length = mappedBytes_;
+    dropped = madvise(data_, mappedBytes_, MADV_DONTNEED) == 0;
+  }
+#endif
+  // Slices of whole huge pages, so no page is shared between threads
+  size_t pages = std::max<size_t>(roundUp(length, HUGE_PAGE_SIZE), 1) /
+                 HUGE_PAGE_SIZE;
+  threads = static_cast<int>(std::min<size_t>(std::max(threads, 1), pages));
+  size_t slicePages = (pages + threads - 1) / threads;
+  threads = static_cast<int>((pages + slicePages - 1) / slicePages);
+  size_t slice = slicePages * HUGE_PAGE_SIZE;
+  char *bytes = static_cast<char *>(data_);
+  auto zero = [=](size_t begin) {
+    size_t end = std::min(begin + slice, length);
+    if (!dropped) {
+      std::memset(bytes + begin, 0, end - begin);
+      return;
+    }
+    for (size_t offset = begin; offset < end; offset += SMALL_PAGE_SIZE)
+      static_cast<volatile char *>(bytes)[offset] = 0;
+  };
+
+  std::vector<std::thread> helpers;
+  for (int i = 1; i < threads; ++i)
+    helpers.emplace_back(zero, i * slice);
+  zero(0);
+  for (std::thread &helper : helpers)
+    helper.join();
+}
+
+LargePageBuffer::Stats LargePageBuffer::stats() const {
+  Stats stats{backing_, bytes_, bytes_, 0};
+#ifdef __linux__
+  if (backing_ == Backing::EXPLICIT_HUGE_PAGES) {
+    stats.hugePageBytes = mappedBytes_;
+    return stats;
+  }
+  if (backing_ != Backing::TRANSPARENT_HUGE_PAGES)
+    return stats;
+
+  // The mapping's own entry in smaps; the kernel may have merged it with a
+  // neighbour, which only makes the figures approximate
+  FILE *smaps = std::fopen("/proc/self/smaps", "r");
+  if (smaps == nullptr)
+    return stats;
+  uintptr_t address = reinterpret_cast<uintptr_t>(data_);
+  bool inMapping = false;
+  char line[256];
+  while (std::fgets(line, sizeof(line), smaps)) {
+    unsigned long start, end;
+    size_t kilobytes;
+    if (std::sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+      inMapping = start <= address && address < end;
+    } else if (inMapping && std::sscanf(line, "Rss: %zu kB", &kilobytes) == 1) {
+      stats.residentBytes = kilobytes << 10;
+    } else if (inMapping &&
+               std::sscanf(line, "AnonHugePages: %zu kB", &kilobytes) == 1) {
+      stats.hugePageBytes = kilobytes << 10;
+    }
+  }
+  std::fclose(smaps);
+#endif
+  return stats;
+}
+
+const char *LargePageBuffer::backingName(Backing backing) {
+  switch (backing) {
+  case Backing::EXPLICIT_HUGE_PAGES:
+    return "explicit huge pages";
+  case Backing::TRANSPARENT_HUGE_PAGES:
+    return "transparent huge pages";
+  case Backing::HEAP:
+    break;
+  }
+  return "heap";
+}
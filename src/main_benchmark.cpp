@@ -0,0 +1,405 @@
+#include "bitboard_ai_agent.h"
+#include "board.h"
+#include "mcts_ai_agent.h"
+#include "panda_ai_agent.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Node throughput and speedup of BitBoardAIAgent's parallel search at 1, 2,
+// 4, 8 and 16 threads. Every thread count searches the same positions to
+// the same fixed depth, so the times compare directly; nodes grow with the
+// thread count as parallel search does work serial search would prune.
+//
+// It then times transposition table probes on their own, one after another
+// as a search makes them, cold and with each node's worth of buckets
+// prefetched first, as the searches do for a node's children.
+//
+// Last, PandaAIAgent's negamax searches the same positions to a fixed depth
+// twice, copying the board for each child and then making and unmaking
+// moves on one board. The trees are identical, so only the time should
+// differ. It ends with the size of MCTSAiAgent's trees after a fixed-time
+// search of each position.
+//
+// With --self-test it instead checks every BitBoard backend the CPU supports
+// against the scalar kernels on random positions, single and batched at
+// every lane count MCTS playouts use, and exits non-zero on any difference.
+//
+// Usage: othello_benchmark [depth] [max threads]
+//        othello_benchmark --self-test [positions]
+
+namespace {
+
+struct BenchmarkPosition {
+  uint64_t black;
+  uint64_t white;
+  bool blackToMove;
+};
+
+// Random playouts from the start, 16 to 44 plies in
+const BenchmarkPosition POSITIONS[] = {
+    {0x00000068200e7808ULL, 0x0000101418500010ULL, true},
+    {0x0000005858080808ULL, 0x00043d2224e01400ULL, true},
+    {0x000e0409060e1c00ULL, 0x00009a7078504000ULL, true},
+    {0x000082b0b7031120ULL, 0x3810780c482c0800ULL, true},
+    {0x00e0004fecc4c004ULL, 0x00117230103a1502ULL, true},
+    {0x091d7b63a1622420ULL, 0x0242041c1c141810ULL, true},
+    {0x02040832570a0400ULL, 0xf858f6cca830391cULL, true},
+    {0x3030cc9a90d06070ULL, 0x4c4830646c2f9e09ULL, true},
+};
+
+// Long enough that every search reaches its depth
+constexpr std::chrono::milliseconds NO_LIMIT{3600000};
+
+// Pages touched on 4 KB pages cost a TLB entry each, those on huge pages
+// one per 2 MB
+void printTableStats(const LargePageBuffer::Stats &stats) {
+  constexpr size_t MB = size_t{1} << 20;
+  size_t smallPageBytes = stats.residentBytes > stats.hugePageBytes
+                              ? stats.residentBytes - stats.hugePageBytes
+                              : 0;
+  std::cout << "Transposition table: " << stats.bytes / MB << " MB on "
+            << LargePageBuffer::backingName(stats.backing) << ", "
+            << stats.residentBytes / MB << " MB touched, "
+            << stats.hugePageBytes / MB << " MB on huge pages; "
+            << stats.hugePageBytes / (2 * MB) + smallPageBytes / 4096
+            << " pages to map" << std::endl;
+}
+
+// Children per node when timing prefetched probes, about an Othello
+// position's mobility
+constexpr int PREFETCH_BATCH = 8;
+constexpr int PROBE_COUNT = 1 << 22;
+// Keeps the probes' results alive
+volatile uint64_t probeSink;
+
+// Average nanoseconds per probe. Each key depends on the previous probe's
+// result, so the misses of a batch only overlap where prefetches let them.
+double timeProbes(const TranspositionTable &table,
+                  const std::vector<uint64_t> &keys, bool prefetch) {
+  TranspositionTable::Entry entry{};
+  uint64_t chain = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < keys.size(); i += PREFETCH_BATCH) {
+    if (prefetch) {
+      for (int j = 0; j < PREFETCH_BATCH; ++j) {
+        table.prefetch(keys[i + j]);
+      }
+    }
+    for (int j = 0; j < PREFETCH_BATCH; ++j) {
+      // chain never reaches 2^63, so the key is unchanged but the probe
+      // waits for the depth the last one loaded
+      uint64_t key = keys[i + j] ^ (chain >> 63);
+      if (table.probe(key, entry))
+        chain += entry.depth;
+    }
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  probeSink = chain;
+  return seconds * 1e9 / keys.size();
+}
+
+void benchmarkProbes(size_t megabytes) {
+  TranspositionTable table(megabytes);
+  std::mt19937_64 random(1);
+  // Probes that miss load nothing the next probe could wait for, so the
+  // keys are ones stored in a half-full table, which keeps nearly all
+  std::vector<uint64_t> stored(table.capacity() / 2);
+  for (size_t i = 0; i < stored.size(); ++i) {
+    stored[i] = random();
+    table.store(stored[i], 0, static_cast<int>(i & 0x3F), TTBound::EXACT);
+  }
+  std::vector<uint64_t> keys(PROBE_COUNT);
+  for (auto &key : keys) {
+    key = stored[random() % stored.size()];
+  }
+
+  timeProbes(table, keys, false);
+  double cold = timeProbes(table, keys, false);
+  double prefetched = timeProbes(table, keys, true);
+  std::cout << "Probes into " << megabytes << " MB: " << std::setprecision(1)
+            << cold << " ns cold, " << prefetched << " ns prefetched "
+            << PREFETCH_BATCH << " at a time, "
+            << std::setprecision(0) << 100.0 * (1.0 - prefetched / cold)
+            << "% of the latency hidden" << std::endl;
+}
+
+// Panda's nodes cost more than BitBoardAIAgent's; this takes about a second
+constexpr int NEGAMAX_DEPTH = 10;
+
+// Seconds and nodes of Panda's negamax over all positions
+std::pair<double, uint64_t> timeNegamax(int depth, bool copyMake) {
+  PandaAIAgent agent("Benchmark", "System");
+  agent.setCopyMake(copyMake);
+  agent.onGameStart();
+  uint64_t nodes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &position : POSITIONS) {
+    agent.searchToDepth(BitBoard(position.black, position.white),
+                        position.blackToMove, depth);
+    nodes += agent.getLastSearchNodes();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return {seconds, nodes};
+}
+
+void benchmarkMakeUnmake(int depth) {
+  auto [copySeconds, copyNodes] = timeNegamax(depth, true);
+  auto [makeSeconds, makeNodes] = timeNegamax(depth, false);
+  std::cout << "Panda negamax, depth " << depth << ": copy-make "
+            << std::setprecision(3) << copySeconds << " s for " << copyNodes
+            << " nodes, make/unmake " << makeSeconds << " s for " << makeNodes
+            << " nodes, " << std::setprecision(2) << copySeconds / makeSeconds
+            << "x" << std::endl;
+}
+
+// How much of MCTSAiAgent's node pool a search of each position fills
+void benchmarkTreeMemory(std::chrono::milliseconds limit) {
+  constexpr double MB = 1 << 20;
+  MCTSAiAgent agent("Benchmark", "System");
+  agent.onGameStart();
+  uint64_t nodes = 0;
+  size_t bytes = 0;
+  for (const auto &position : POSITIONS) {
+    Board board = Board::fromBitBoard(BitBoard(position.black, position.white));
+    agent.getBestMove(board,
+                      position.blackToMove ? CellState::BLACK
+                                           : CellState::WHITE,
+                      limit);
+    nodes += agent.getTreeNodes();
+    bytes += agent.getTreeMemoryUsed();
+  }
+  size_t count = sizeof(POSITIONS) / sizeof(POSITIONS[0]);
+  std::cout << "MCTS, " << limit.count() << " ms per position: "
+            << nodes / count << " nodes in "
+            << std::setprecision(1) << bytes / count / MB << " of "
+            << agent.getTreeMemoryCapacity() / MB << " MB on average, "
+            << mcts::Mcts::BYTES_PER_NODE << " bytes per node" << std::endl;
+}
+
+// Positions for the self-test: half are taken from random games, the other
+// half are random disjoint masks of varying density, which reach shapes no
+// game does.
+BitBoard randomPosition(std::mt19937_64 &random) {
+  if (random() & 1) {
+    uint64_t black = random(), white = random();
+    switch (random() % 3) {
+    case 0:
+      black &= random();
+      white &= random();
+      break;
+    case 1:
+      black &= random() & random();
+      break;
+    default:
+      break;
+    }
+    return BitBoard(black, white & ~black);
+  }
+  BitBoard board;
+  bool black = true;
+  int plies = static_cast<int>(random() % 60);
+  for (int ply = 0; ply < plies; ++ply) {
+    uint64_t moves = board.legalMovesMask(black);
+    if (moves == 0) {
+      black = !black;
+      moves = board.legalMovesMask(black);
+      if (moves == 0)
+        break;
+    }
+    for (int skip = static_cast<int>(random() % __builtin_popcountll(moves));
+         skip > 0; --skip) {
+      moves &= moves - 1;
+    }
+    board.makeMoveUnchecked(__builtin_ctzll(moves), black);
+    black = !black;
+  }
+  return board;
+}
+
+// A square to flip from: usually a legal move, sometimes any empty square
+// or none at all, which must flip nothing
+uint64_t randomMove(uint64_t player, uint64_t opponent, uint64_t legal,
+                    std::mt19937_64 &random) {
+  uint64_t empty = ~(player | opponent);
+  uint64_t choices = (random() % 4 != 0 && legal != 0) ? legal : empty;
+  if (choices == 0 || random() % 16 == 0)
+    return 0;
+  for (int skip = static_cast<int>(random() % __builtin_popcountll(choices));
+       skip > 0; --skip) {
+    choices &= choices - 1;
+  }
+  return choices & (0 - choices);
+}
+
+const char *backendName(BitBoard::Backend backend) {
+  return backend == BitBoard::Backend::AVX2 ? "AVX2" : "scalar";
+}
+
+// Checks one backend against the scalar kernels; returns the mismatches
+long checkBackend(BitBoard::Backend backend, long positions) {
+  constexpr int LANES = mcts::PlayoutBatch::MAX_LANES;
+  std::mt19937_64 random(3);
+  long mismatches = 0;
+  auto report = [&](const char *kernel, uint64_t player, uint64_t opponent,
+                    uint64_t move, uint64_t expected, uint64_t actual) {
+    if (mismatches++ < 10) {
+      std::cerr << backendName(backend) << " " << kernel << " differs: player "
+                << std::hex << player << " opponent " << opponent << " move "
+                << move << ": " << actual << " instead of " << expected
+                << std::dec << std::endl;
+    }
+  };
+
+  uint64_t player[LANES], opponent[LANES], move[LANES];
+  uint64_t legal[LANES], flips[LANES], batchOut[LANES];
+  // Flips of every legal move, not just the sampled one
+  uint64_t flipsAt[LANES][BitBoard::TOTAL_CELLS];
+  long done = 0;
+  for (int lanes = 1; done < positions; lanes = lanes % LANES + 1) {
+    // Reference results, from the scalar kernels
+    BitBoard::setBackend(BitBoard::Backend::SCALAR);
+    for (int i = 0; i < lanes; ++i) {
+      BitBoard board = randomPosition(random);
+      bool black = random() & 1;
+      player[i] = board.getPlayerBoard(black);
+      opponent[i] = board.getOpponentBoard(black);
+      legal[i] = BitBoard::legalMovesMask(player[i], opponent[i]);
+      for (uint64_t m = legal[i]; m; m &= m - 1) {
+        int bit = __builtin_ctzll(m);
+        flipsAt[i][bit] = BitBoard::flipsMask(bit, player[i], opponent[i]);
+      }
+      move[i] = randomMove(player[i], opponent[i], legal[i], random);
+      flips[i] = move[i] ? BitBoard::flipsMask(__builtin_ctzll(move[i]),
+                                               player[i], opponent[i])
+                         : 0;
+    }
+
+    BitBoard::setBackend(backend);
+    for (int i = 0; i < lanes; ++i) {
+      uint64_t moves = BitBoard::legalMovesMask(player[i], opponent[i]);
+      if (moves != legal[i])
+        report("legalMovesMask", player[i], opponent[i], 0, legal[i], moves);
+      for (uint64_t m = legal[i]; m; m &= m - 1) {
+        int bit = __builtin_ctzll(m);
+        uint64_t actual = BitBoard::flipsMask(bit, player[i], opponent[i]);
+        if (actual != flipsAt[i][bit])
+          report("flipsMask", player[i], opponent[i], m & (0 - m),
+                 flipsAt[i][bit], actual);
+      }
+    }
+    BitBoard::legalMovesMaskBatch(player, opponent, batchOut, lanes);
+    for (int i = 0; i < lanes; ++i) {
+      if (batchOut[i] != legal[i])
+        report("legalMovesMaskBatch", player[i], opponent[i], 0, legal[i],
+               batchOut[i]);
+    }
+    BitBoard::flipsMaskBatch(move, player, opponent, batchOut, lanes);
+    for (int i = 0; i < lanes; ++i) {
+      if (batchOut[i] != flips[i])
+        report("flipsMaskBatch", player[i], opponent[i], move[i], flips[i],
+               batchOut[i]);
+    }
+    done += lanes;
+  }
+  return mismatches;
+}
+
+int runSelfTest(long positions) {
+  BitBoard::Backend detected = BitBoard::getBackend();
+  long mismatches = 0;
+  for (BitBoard::Backend backend :
+       {BitBoard::Backend::SCALAR, BitBoard::Backend::AVX2}) {
+    if (!BitBoard::isBackendSupported(backend)) {
+      std::cout << backendName(backend)
+                << " backend: not supported by this CPU, skipped" << std::endl;
+      continue;
+    }
+    long found = checkBackend(backend, positions);
+    std::cout << backendName(backend) << " backend: " << positions
+              << " positions, " << found << " mismatches" << std::endl;
+    mismatches += found;
+  }
+  BitBoard::setBackend(detected);
+  return mismatches == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::strcmp(argv[1], "--self-test") == 0) {
+    long positions = argc > 2 ? std::atol(argv[2]) : 4000000;
+    if (positions < 1) {
+      std::cerr << "Usage: " << argv[0] << " --self-test [positions]"
+                << std::endl;
+      return 1;
+    }
+    return runSelfTest(positions);
+  }
+
+  int depth = argc > 1 ? std::atoi(argv[1]) : 9;
+  int maxThreads = argc > 2 ? std::atoi(argv[2]) : 16;
+  if (depth < 1 || maxThreads < 1) {
+    std::cerr << "Usage: " << argv[0] << " [depth] [max threads]" << std::endl;
+    return 1;
+  }
+
+  unsigned cores = std::thread::hardware_concurrency();
+  std::cout << "Parallel search benchmark: depth " << depth << ", "
+            << sizeof(POSITIONS) / sizeof(POSITIONS[0]) << " positions, "
+            << cores << " cores" << std::endl;
+  std::cout << std::left << std::setw(9) << "Threads" << std::setw(14)
+            << "Nodes" << std::setw(11) << "Time (s)" << std::setw(13)
+            << "Nodes/s" << "Speedup" << std::endl;
+
+  double serialSeconds = 0.0;
+  LargePageBuffer::Stats serialTable{};
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    BitBoardAIAgent agent("Benchmark", "System", depth, threads);
+    agent.onGameStart();
+    uint64_t nodes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &position : POSITIONS) {
+      Board board =
+          Board::fromBitBoard(BitBoard(position.black, position.white));
+      agent.getBestMove(board,
+                        position.blackToMove ? CellState::BLACK
+                                             : CellState::WHITE,
+                        NO_LIMIT);
+      nodes += agent.getLastSearchNodes();
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    if (threads == 1) {
+      serialSeconds = seconds;
+      serialTable = agent.getTableMemoryStats();
+    }
+
+    std::cout << std::left << std::setw(9) << threads << std::setw(14)
+              << nodes << std::setw(11) << std::fixed << std::setprecision(3)
+              << seconds << std::setw(13) << std::setprecision(0)
+              << nodes / seconds << std::setprecision(2)
+              << serialSeconds / seconds << "x";
+    if (cores != 0 && static_cast<unsigned>(threads) > cores) {
+      std::cout << " (more threads than cores)";
+    }
+    std::cout << std::endl;
+  }
+  printTableStats(serialTable);
+  benchmarkProbes(64);
+  benchmarkMakeUnmake(NEGAMAX_DEPTH);
+  benchmarkTreeMemory(std::chrono::milliseconds(200));
+
+  return 0;
+}
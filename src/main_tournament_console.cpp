@@ -1,8 +1,15 @@
+#include "agent_sandbox.h"
 #include "tournament_console.h"
+#include <cstring>
 #include <exception>
 #include <iostream>
 
-int main() {
+int main(int argc, char *argv[]) {
+  // Sandboxed agents run in copies of this executable
+  if (argc > 1 && std::strcmp(argv[1], AGENT_WORKER_FLAG) == 0) {
+    return runAgentWorker();
+  }
+
   try {
     TournamentConsole console;
     console.run();
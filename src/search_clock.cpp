@@ -0,0 +1,86 @@
+#include "search_clock.h"
+#include <algorithm>
+
+void SearchClock::start(std::chrono::milliseconds softLimit,
+                        std::chrono::milliseconds hardLimit) {
+  startTime_ = Clock::now();
+  softDeadline_ = startTime_ + std::min(softLimit, hardLimit);
+  hardDeadline_ = startTime_ + hardLimit;
+  lastPoll_ = startTime_;
+  stopped_.store(false, std::memory_order_relaxed);
+
+  stride_ = MIN_STRIDE;
+  countdown_ = stride_;
+  polledNodes_ = 0;
+
+  iterationStart_ = startTime_;
+  iterationStartNodes_ = 0;
+  lastIterationTime_ = Clock::duration::zero();
+  lastIterationNodes_ = 0;
+  previousIterationNodes_ = 0;
+}
+
+bool SearchClock::poll() {
+  auto now = Clock::now();
+  polledNodes_ += static_cast<uint64_t>(stride_);
+
+  // Rescale the stride to the node rate just measured
+  auto sincePoll = std::max(now - lastPoll_, Clock::duration(1));
+  auto interval = std::chrono::duration_cast<Clock::duration>(POLL_INTERVAL);
+  int64_t target = int64_t{stride_} * interval.count() / sincePoll.count();
+  target = std::min(target, int64_t{stride_} * MAX_GROWTH);
+  stride_ = static_cast<int32_t>(
+      std::clamp<int64_t>(target, MIN_STRIDE, MAX_STRIDE));
+  countdown_ = stride_;
+  lastPoll_ = now;
+
+  if (now >= hardDeadline_) {
+    stop();
+    return true;
+  }
+  return false;
+}
+
+bool SearchClock::hardTimeUp() {
+  if (stopped())
+    return true;
+  if (Clock::now() >= hardDeadline_) {
+    stop();
+    return true;
+  }
+  return false;
+}
+
+void SearchClock::iterationDone() {
+  auto now = Clock::now();
+  uint64_t total = nodes();
+  previousIterationNodes_ = lastIterationNodes_;
+  lastIterationNodes_ = total - iterationStartNodes_;
+  lastIterationTime_ = now - iterationStart_;
+  iterationStartNodes_ = total;
+  iterationStart_ = now;
+}
+
+double SearchClock::branchingFactor() const {
+  if (previousIterationNodes_ == 0)
+    return 0.0;
+  return static_cast<double>(lastIterationNodes_) /
+         static_cast<double>(previousIterationNodes_);
+}
+
+bool SearchClock::nextIterationFits() const {
+  if (stopped())
+    return false;
+  auto now = Clock::now();
+  if (now >= softDeadline_)
+    return false;
+
+  // Too few iterations to measure, or shallow ones cut short by the
+  // transposition table; let the hard deadline decide
+  double factor = branchingFactor();
+  if (factor < 1.0)
+    return true;
+  auto predicted = std::chrono::duration_cast<Clock::duration>(
+      lastIterationTime_ * factor);
+  return now + predicted < hardDeadline_;
+}
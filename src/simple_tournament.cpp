@@ -1,17 +1,82 @@
 #include "simple_tournament.h"
+#include "agent_sandbox.h"
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <thread>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// CPUs this process may run on, in order
+std::vector<int> allowedCpus() {
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set))
+        cpus.push_back(cpu);
+    }
+  }
+#endif
+  return cpus;
+}
+
+void pinCurrentThread(int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cpu;
+#endif
+}
+
+// Puts the current thread's CPU affinity back when it goes out of scope
+class AffinityGuard {
+public:
+  AffinityGuard() {
+#ifdef __linux__
+    CPU_ZERO(&set_);
+    saved_ = pthread_getaffinity_np(pthread_self(), sizeof(set_), &set_) == 0;
+#endif
+  }
+  ~AffinityGuard() {
+#ifdef __linux__
+    if (saved_)
+      pthread_setaffinity_np(pthread_self(), sizeof(set_), &set_);
+#endif
+  }
+  AffinityGuard(const AffinityGuard &) = delete;
+  AffinityGuard &operator=(const AffinityGuard &) = delete;
+
+private:
+#ifdef __linux__
+  cpu_set_t set_;
+  bool saved_ = false;
+#endif
+};
+
+} // namespace
+
 SimpleTournament::SimpleTournament() {}
 
 void SimpleTournament::addAgent(std::unique_ptr<AIAgentBase> agent) {
   if (agent) {
     agents_.push_back(std::move(agent));
+    agentTypes_.emplace_back();
   }
 }
 
@@ -20,11 +85,13 @@ void SimpleTournament::addAgent(const std::string &type,
   auto agent = createAIAgent(type, name.empty() ? type : name);
   if (agent) {
     agents_.push_back(std::move(agent));
+    agentTypes_.push_back(type);
   }
 }
 
 void SimpleTournament::clearAgents() {
   agents_.clear();
+  agentTypes_.clear();
   gameResults_.clear();
   agentStats_.clear();
 }
@@ -35,63 +102,232 @@ void SimpleTournament::runRoundRobin() {
     return;
   }
 
-  int totalMatchups = (agents_.size() * (agents_.size() - 1)) / 2;
-  int totalGames = totalMatchups * config_.roundsPerMatchup * 2;
+  auto schedule = buildRoundRobinSchedule();
+  int threads = std::max(1, config_.threads);
+  if (threads > static_cast<int>(schedule.size())) {
+    threads = static_cast<int>(schedule.size());
+  }
 
   std::cout << "Starting Round Robin Tournament" << std::endl;
   std::cout << "Agents: " << agents_.size() << std::endl;
   std::cout << "Rounds per matchup: " << config_.roundsPerMatchup
             << " (each round plays both sides for fairness)" << std::endl;
-  std::cout << "Time limit per move: " << config_.timeLimit.count() << "ms"
-            << std::endl;
-  std::cout << "Total games: " << totalGames << std::endl;
+  std::cout << "Time control: " << timeControlLabel() << std::endl;
+  std::cout << "Total games: " << schedule.size() << std::endl;
+  if (threads > 1) {
+    std::cout << "Parallel games: " << threads
+              << (config_.pinThreads ? " (pinned)" : "") << std::endl;
+    unsigned cores = std::thread::hardware_concurrency();
+    if (cores != 0 && static_cast<unsigned>(threads) > cores) {
+      std::cout << "Warning: more parallel games than the " << cores
+                << " available cores, move times will include waiting"
+                << std::endl;
+    }
+  }
   std::cout << std::string(50, '=') << std::endl;
-  int currentGame = 0;
 
   for (const auto &agent : agents_) {
     agentStats_[agent->getName()] = AgentStats();
     agentStats_[agent->getName()].agentName = agent->getName();
   }
 
+  bool sandboxed = config_.sandboxAgents;
+  if (sandboxed && !isSandboxSupported()) {
+    std::cout << "Agent sandbox is not supported on this platform, running "
+                 "agents in process"
+              << std::endl;
+    sandboxed = false;
+  }
+  if ((threads > 1 || sandboxed) && !canCreateWorkerAgents()) {
+    std::cout << "Some agents were added as instances and can't be recreated "
+                 "per thread or process, playing games sequentially in process"
+              << std::endl;
+    threads = 1;
+    sandboxed = false;
+  }
+
+  bool pondering = config_.allowPondering;
+  if (pondering && allowedCpus().size() < 2 * static_cast<size_t>(threads)) {
+    std::cout << "Pondering needs two CPUs per parallel game, playing "
+                 "without it"
+              << std::endl;
+    pondering = false;
+  }
+
+  if (sandboxed) {
+    // Pay for fork and exec now rather than during the first games
+    prestartAgentWorkers(static_cast<int>(agents_.size()) * threads);
+  }
+
+  if (threads > 1) {
+    playScheduleParallel(schedule, threads, sandboxed, pondering);
+  } else {
+    playSchedule(schedule, sandboxed, pondering);
+  }
+
+  std::cout << "\n" << std::string(50, '=') << std::endl;
+  std::cout << "Tournament Complete!" << std::endl;
+  printResults();
+}
+
+// Every pairing plays roundsPerMatchup rounds, each round being one game with
+// either agent as black. This is the order games are recorded in, whether
+// they are played sequentially or in parallel.
+std::vector<SimpleTournament::ScheduledGame>
+SimpleTournament::buildRoundRobinSchedule() const {
+  std::vector<ScheduledGame> schedule;
   for (size_t i = 0; i < agents_.size(); ++i) {
     for (size_t j = i + 1; j < agents_.size(); ++j) {
-      std::string matchup =
-          agents_[i]->getName() + " vs " + agents_[j]->getName();
-      std::cout << "\nMatchup: " << matchup << std::endl;
-
       for (int round = 0; round < config_.roundsPerMatchup; ++round) {
-        currentGame++;
+        schedule.push_back({i, j, round, false});
+        schedule.push_back({j, i, round, true});
+      }
+    }
+  }
+  return schedule;
+}
 
-        if (progressCallback_) {
-          progressCallback_(currentGame, totalGames, matchup);
-        }
-        printProgress(currentGame, totalGames, matchup);
+std::string SimpleTournament::matchupLabel(const ScheduledGame &game) const {
+  if (game.reversed) {
+    return agents_[game.white]->getName() + " vs " +
+           agents_[game.black]->getName() + " (reversed)";
+  }
+  return agents_[game.black]->getName() + " vs " +
+         agents_[game.white]->getName();
+}
+
+void SimpleTournament::playSchedule(
+    const std::vector<ScheduledGame> &schedule, bool sandboxed,
+    bool pondering) {
+  int totalGames = static_cast<int>(schedule.size());
+  int currentGame = 0;
+  std::vector<int> sideCpus;
+  if (pondering) {
+    sideCpus = allowedCpus();
+    sideCpus.resize(2);
+  }
+
+  std::vector<std::unique_ptr<AIAgentBase>> sandboxedAgents;
+  if (sandboxed) {
+    for (size_t i = 0; i < agents_.size(); ++i) {
+      sandboxedAgents.push_back(createWorkerAgent(i, true));
+    }
+  }
+  auto agentFor = [&](size_t index) {
+    return sandboxed ? sandboxedAgents[index].get() : agents_[index].get();
+  };
+
+  for (const auto &game : schedule) {
+    std::string matchup = matchupLabel(game);
+    if (game.round == 0 && !game.reversed) {
+      std::cout << "\nMatchup: " << matchup << std::endl;
+    }
+
+    currentGame++;
 
-        auto result1 = playSingleGame(agents_[i].get(), agents_[j].get());
-        gameResults_.push_back(result1);
-        updateStats(result1);
+    if (progressCallback_) {
+      progressCallback_(currentGame, totalGames, matchup);
+    }
+    printProgress(currentGame, totalGames, matchup);
 
-        currentGame++;
+    auto result = playGame(agentFor(game.black), agentFor(game.white),
+                           pondering, sideCpus);
+    gameResults_.push_back(result);
+    updateStats(result);
+  }
+}
 
-        if (progressCallback_) {
-          progressCallback_(currentGame, totalGames, matchup + " (reversed)");
-        }
-        printProgress(currentGame, totalGames, matchup + " (reversed)");
+// Workers pull games off a shared counter and write each result into its
+// schedule slot. Stats are merged afterwards in schedule order, so results
+// and rankings don't depend on which games finished first.
+void SimpleTournament::playScheduleParallel(
+    const std::vector<ScheduledGame> &schedule, int threads, bool sandboxed,
+    bool pondering) {
+  int totalGames = static_cast<int>(schedule.size());
+  std::vector<GameResult> results(schedule.size());
+  std::atomic<size_t> nextGame{0};
+  std::mutex progressMutex;
+  int completedGames = 0;
+  std::vector<int> cpus = config_.pinThreads || pondering
+                              ? allowedCpus()
+                              : std::vector<int>();
+
+  auto worker = [&](int workerId) {
+    // A pondering game moves between its two CPUs as the sides alternate
+    std::vector<int> sideCpus;
+    if (pondering) {
+      sideCpus = {cpus[2 * workerId], cpus[2 * workerId + 1]};
+    } else if (!cpus.empty()) {
+      pinCurrentThread(cpus[workerId % cpus.size()]);
+    }
 
-        auto result2 = playSingleGame(agents_[j].get(), agents_[i].get());
-        gameResults_.push_back(result2);
-        updateStats(result2);
+    // Created on first use, then kept for the rest of this worker's games
+    // like the shared instances are in a sequential tournament
+    std::vector<std::unique_ptr<AIAgentBase>> localAgents(agents_.size());
+    auto agentFor = [&](size_t index) {
+      if (!localAgents[index]) {
+        localAgents[index] = createWorkerAgent(index, sandboxed);
+      }
+      return localAgents[index].get();
+    };
+
+    for (size_t k = nextGame++; k < schedule.size(); k = nextGame++) {
+      const auto &game = schedule[k];
+      results[k] = playGame(agentFor(game.black), agentFor(game.white),
+                            pondering, sideCpus);
+
+      std::lock_guard<std::mutex> lock(progressMutex);
+      completedGames++;
+      std::string matchup = matchupLabel(game);
+      if (progressCallback_) {
+        progressCallback_(completedGames, totalGames, matchup);
       }
+      printProgress(completedGames, totalGames, matchup);
     }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back(worker, t);
+  }
+  for (auto &thread : workers) {
+    thread.join();
   }
 
-  std::cout << "\n" << std::string(50, '=') << std::endl;
-  std::cout << "Tournament Complete!" << std::endl;
-  printResults();
+  for (const auto &result : results) {
+    gameResults_.push_back(result);
+    updateStats(result);
+  }
+}
+
+bool SimpleTournament::canCreateWorkerAgents() const {
+  return std::none_of(agentTypes_.begin(), agentTypes_.end(),
+                      [](const std::string &type) { return type.empty(); });
+}
+
+std::unique_ptr<AIAgentBase>
+SimpleTournament::createWorkerAgent(size_t index, bool sandboxed) const {
+  const std::string &name = agents_[index]->getName();
+  if (sandboxed) {
+    SandboxLimits limits;
+    limits.memoryLimitMB = config_.agentMemoryLimitMB;
+    return std::make_unique<SandboxedAgent>(agentTypes_[index], name, limits);
+  }
+  return createAIAgent(agentTypes_[index], name);
 }
 
 GameResult SimpleTournament::playSingleGame(AIAgentBase *blackAgent,
                                             AIAgentBase *whiteAgent) {
+  return playGame(blackAgent, whiteAgent, false, {});
+}
+
+// With pondering on, an agent's background search starts from inside its
+// own move, so it inherits that side's CPU and only competes with itself
+GameResult SimpleTournament::playGame(AIAgentBase *blackAgent,
+                                      AIAgentBase *whiteAgent, bool pondering,
+                                      const std::vector<int> &sideCpus) {
+  AffinityGuard affinity;
   GameResult result;
   result.blackAgent = blackAgent->getName();
   result.whiteAgent = whiteAgent->getName();
@@ -100,9 +336,18 @@ GameResult SimpleTournament::playSingleGame(AIAgentBase *blackAgent,
   CellState currentPlayer = CellState::BLACK;
   int moveCount = 0;
 
+  // Game clocks and moves played, indexed by colour (0 = black). Clocks run
+  // at steady_clock precision, so sub-millisecond moves are charged too.
+  bool gameClock = config_.gameTime.count() > 0;
+  std::chrono::steady_clock::duration clocks[2] = {config_.gameTime,
+                                                   config_.gameTime};
+  int movesPlayed[2] = {0, 0};
+
   auto gameStart = std::chrono::steady_clock::now();
 
   try {
+    blackAgent->setPonderingAllowed(pondering);
+    whiteAgent->setPonderingAllowed(pondering);
     blackAgent->onGameStart();
     whiteAgent->onGameStart();
   } catch (...) {
@@ -119,9 +364,26 @@ GameResult SimpleTournament::playSingleGame(AIAgentBase *blackAgent,
       continue;
     }
 
+    int side = currentPlayer == CellState::BLACK ? 0 : 1;
+    if (!sideCpus.empty()) {
+      pinCurrentThread(sideCpus[side]);
+    }
+    // Agents see their bank rounded down to whole milliseconds
+    auto bank =
+        std::chrono::duration_cast<std::chrono::milliseconds>(clocks[side]);
+    TimeBudget budget =
+        gameClock
+            ? TimeBudget::clock(bank, config_.increment, movesPlayed[side])
+            : TimeBudget::perMove(config_.timeLimit);
+
     bool timedOut = false, crashed = false;
-    auto move = getSafeMove(currentAgent, board, currentPlayer, agentName,
-                            timedOut, crashed);
+    std::chrono::steady_clock::duration elapsed{0};
+    auto move = getSafeMove(currentAgent, board, currentPlayer, budget,
+                            agentName, elapsed, timedOut, crashed);
+    if (gameClock && !timedOut) {
+      clocks[side] += config_.increment - elapsed;
+    }
+    movesPlayed[side]++;
 
     if (timedOut || crashed) {
       if (currentPlayer == CellState::BLACK) {
@@ -192,6 +454,8 @@ GameResult SimpleTournament::playSingleGame(AIAgentBase *blackAgent,
     CellState winner = (result.winner == "BLACK")   ? CellState::BLACK
                        : (result.winner == "WHITE") ? CellState::WHITE
                                                     : CellState::EMPTY;
+    blackAgent->stopPondering();
+    whiteAgent->stopPondering();
     blackAgent->onGameEnd(winner);
     whiteAgent->onGameEnd(winner);
   } catch (...) {
@@ -202,25 +466,31 @@ GameResult SimpleTournament::playSingleGame(AIAgentBase *blackAgent,
 
 std::pair<int, int>
 SimpleTournament::getSafeMove(AIAgentBase *agent, const Board &board,
-                              CellState player, const std::string &agentName,
+                              CellState player, const TimeBudget &budget,
+                              const std::string &agentName,
+                              std::chrono::steady_clock::duration &elapsed,
                               bool &timedOut, bool &crashed) {
   timedOut = false;
   crashed = false;
+  elapsed = std::chrono::steady_clock::duration::zero();
 
   try {
     auto startTime = std::chrono::steady_clock::now();
-    auto move = agent->getBestMove(board, player, config_.timeLimit);
+    auto move = agent->getBestMoveWithBudget(board, player, budget);
     auto endTime = std::chrono::steady_clock::now();
 
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-        endTime - startTime);
-    if (duration > config_.timeLimit) {
+    elapsed = endTime - startTime;
+    if (elapsed > budget.moveLimit) {
       timedOut = true;
       return {-1, -1};
     }
 
     return move;
 
+  } catch (const AgentTimeoutError &e) {
+    timedOut = true;
+    std::cerr << "Agent " << agentName << " " << e.what() << std::endl;
+    return {-1, -1};
   } catch (const std::exception &e) {
     crashed = true;
     std::cerr << "Agent " << agentName << " crashed: " << e.what() << std::endl;
@@ -415,7 +685,14 @@ void SimpleTournament::saveResultsJson(const std::string &filename) const {
   file << "{\n";
   file << "  \"config\": {\n";
   file << "    \"timeLimitMs\": " << config_.timeLimit.count() << ",\n";
+  file << "    \"gameTimeMs\": " << config_.gameTime.count() << ",\n";
+  file << "    \"incrementMs\": " << config_.increment.count() << ",\n";
   file << "    \"roundsPerMatchup\": " << config_.roundsPerMatchup << ",\n";
+  file << "    \"threads\": " << config_.threads << ",\n";
+  file << "    \"sandboxAgents\": "
+       << (config_.sandboxAgents ? "true" : "false") << ",\n";
+  file << "    \"pondering\": "
+       << (config_.allowPondering ? "true" : "false") << ",\n";
   file << "    \"tournamentType\": \"" << config_.tournamentType << "\"\n";
   file << "  },\n";
 
@@ -490,6 +767,17 @@ SimpleTournament::formatDuration(std::chrono::milliseconds duration) const {
   return oss.str();
 }
 
+std::string SimpleTournament::timeControlLabel() const {
+  if (config_.gameTime.count() <= 0) {
+    return std::to_string(config_.timeLimit.count()) + "ms per move";
+  }
+  std::string label = formatDuration(config_.gameTime) + " per game";
+  if (config_.increment.count() > 0) {
+    label += " + " + formatDuration(config_.increment) + " per move";
+  }
+  return label;
+}
+
 std::vector<std::string> SimpleTournament::getAgentNames() const {
   std::vector<std::string> names;
   for (const auto &agent : agents_) {
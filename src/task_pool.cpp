@@ -0,0 +1,100 @@
+#include "task_pool.h"
+#include <algorithm>
+
+namespace {
+thread_local int threadIndex = 0;
+} // namespace
+
+TaskPool::TaskPool(int threads) {
+  int count = std::max(1, threads);
+  for (int i = 0; i < count; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (int i = 1; i < count; ++i) {
+    workers_.emplace_back(&TaskPool::workerLoop, this, i);
+  }
+}
+
+TaskPool::~TaskPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    stopping_ = true;
+  }
+  wakeUp_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+int TaskPool::currentThread() { return threadIndex; }
+
+void TaskPool::submit(Group &group, std::function<void()> task) {
+  group.pending_.fetch_add(1, std::memory_order_relaxed);
+  {
+    Queue &queue = *queues_[threadIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back({std::move(task), &group});
+  }
+  queued_.fetch_add(1, std::memory_order_release);
+
+  // Taking the lock orders this against a worker about to sleep
+  { std::lock_guard<std::mutex> lock(sleepMutex_); }
+  wakeUp_.notify_one();
+}
+
+void TaskPool::wait(Group &group) {
+  while (group.pending_.load(std::memory_order_acquire) > 0) {
+    if (!runOneTask(threadIndex)) {
+      // The rest of the group is running on other threads
+      std::this_thread::yield();
+    }
+  }
+}
+
+void TaskPool::workerLoop(int index) {
+  threadIndex = index;
+  while (true) {
+    if (runOneTask(index))
+      continue;
+
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    wakeUp_.wait(lock, [this] {
+      return stopping_ || queued_.load(std::memory_order_acquire) > 0;
+    });
+    if (stopping_)
+      return;
+  }
+}
+
+bool TaskPool::runOneTask(int index) {
+  if (queued_.load(std::memory_order_acquire) == 0)
+    return false;
+
+  Task task;
+  bool found = false;
+  {
+    Queue &own = *queues_[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      found = true;
+    }
+  }
+  for (size_t i = 1; !found && i < queues_.size(); ++i) {
+    Queue &victim = *queues_[(index + i) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      found = true;
+    }
+  }
+  if (!found)
+    return false;
+
+  queued_.fetch_sub(1, std::memory_order_relaxed);
+  task.run();
+  task.group->pending_.fetch_sub(1, std::memory_order_release);
+  return true;
+}
@@ -1,4 +1,5 @@
 #include "tournament_console.h"
+#include "agent_sandbox.h"
 #include <algorithm>
 #include <cctype>
 #include <chrono>
@@ -40,6 +41,10 @@ void TournamentConsole::run() {
 
     configureRounds();
 
+    configureThreads();
+
+    configureSandbox();
+
     setupAllAgents();
 
     runTournament();
@@ -94,9 +99,19 @@ void TournamentConsole::showConfigurationMenu() {
   auto config = tournament_.getConfig();
   std::cout << "Current Settings:" << std::endl;
   std::cout << "  Type: " << config.tournamentType << std::endl;
-  std::cout << "  Time Limit: " << config.timeLimit.count() << "ms"
-            << std::endl;
+  if (config.gameTime.count() > 0) {
+    std::cout << "  Game Clock: " << config.gameTime.count() << "ms + "
+              << config.increment.count() << "ms per move" << std::endl;
+  } else {
+    std::cout << "  Time Limit: " << config.timeLimit.count() << "ms"
+              << std::endl;
+  }
   std::cout << "  Rounds per Matchup: " << config.roundsPerMatchup << std::endl;
+  std::cout << "  Parallel Games: " << config.threads << std::endl;
+  std::cout << "  Pondering: " << (config.allowPondering ? "Yes" : "No")
+            << std::endl;
+  std::cout << "  Sandboxed Agents: " << (config.sandboxAgents ? "Yes" : "No")
+            << std::endl;
   std::cout << "  Visual Feedback: "
             << (config.enableVisualFeedback ? "Yes" : "No") << std::endl;
   std::cout << "  Log Games: " << (config.logGames ? "Yes" : "No") << std::endl;
@@ -228,7 +243,15 @@ void TournamentConsole::configureTournamentType() {
 
 void TournamentConsole::configureTimeLimit() {
   auto config = tournament_.getConfig();
-  std::cout << "2. Set Time Limit per Move" << std::endl;
+  std::cout << "2. Set Time Control" << std::endl;
+  if (getYesNoInput("   Use a game clock instead of a fixed time per move? "
+                    "(y/n): ")) {
+    configureGameClock();
+    return;
+  }
+  config.gameTime = std::chrono::milliseconds(0);
+  config.increment = std::chrono::milliseconds(0);
+
   std::cout << "   Default: 1000ms" << std::endl;
   std::cout << "   Enter time limit in milliseconds (100-30000) or press Enter "
                "for default: ";
@@ -257,6 +280,58 @@ void TournamentConsole::configureTimeLimit() {
   std::cout << std::endl;
 }
 
+void TournamentConsole::configureGameClock() {
+  auto config = tournament_.getConfig();
+  std::cout << "   Default: 60s per game, no increment" << std::endl;
+  std::cout << "   Enter time per game in seconds (5-3600) or press Enter for "
+               "default: ";
+
+  std::string input;
+  std::getline(std::cin, input);
+
+  int gameSeconds = 60; // Default
+  if (!input.empty()) {
+    try {
+      gameSeconds = std::stoi(input);
+      if (gameSeconds < 5 || gameSeconds > 3600) {
+        std::cout << "   Invalid range, using default 60s" << std::endl;
+        gameSeconds = 60;
+      }
+    } catch (...) {
+      std::cout << "   Invalid input, using default 60s" << std::endl;
+      gameSeconds = 60;
+    }
+  }
+
+  std::cout << "   Enter increment per move in milliseconds (0-10000) or "
+               "press Enter for none: ";
+  std::getline(std::cin, input);
+
+  int increment = 0; // Default
+  if (!input.empty()) {
+    try {
+      increment = std::stoi(input);
+      if (increment < 0 || increment > 10000) {
+        std::cout << "   Invalid range, using no increment" << std::endl;
+        increment = 0;
+      }
+    } catch (...) {
+      std::cout << "   Invalid input, using no increment" << std::endl;
+      increment = 0;
+    }
+  }
+
+  config.gameTime = std::chrono::seconds(gameSeconds);
+  config.increment = std::chrono::milliseconds(increment);
+  tournament_.setConfig(config);
+
+  std::cout << "   ✓ Game clock: " << gameSeconds << "s per game";
+  if (increment > 0) {
+    std::cout << " + " << increment << "ms per move";
+  }
+  std::cout << std::endl << std::endl;
+}
+
 void TournamentConsole::configureRounds() {
   auto config = tournament_.getConfig();
   std::cout << "3. Set Number of Rounds" << std::endl;
@@ -291,11 +366,101 @@ void TournamentConsole::configureRounds() {
   std::cout << std::endl;
 }
 
+void TournamentConsole::configureThreads() {
+  auto config = tournament_.getConfig();
+  unsigned cores = std::thread::hardware_concurrency();
+  int maxThreads = cores > 0 ? static_cast<int>(cores) : 1;
+
+  std::cout << "4. Set Parallel Games" << std::endl;
+  std::cout << "   Available cores: " << maxThreads << std::endl;
+  std::cout << "   Default: 1 (sequential)" << std::endl;
+  std::cout << "   Enter number of games to play at once (1-" << maxThreads
+            << ") or press Enter for default: ";
+
+  std::string input;
+  std::getline(std::cin, input);
+
+  int threads = 1; // Default
+  if (!input.empty()) {
+    try {
+      threads = std::stoi(input);
+      if (threads < 1 || threads > maxThreads) {
+        std::cout << "   Invalid range, using default 1" << std::endl;
+        threads = 1;
+      }
+    } catch (...) {
+      std::cout << "   Invalid input, using default 1" << std::endl;
+      threads = 1;
+    }
+  }
+
+  config.threads = threads;
+  config.pinThreads =
+      threads > 1 && getYesNoInput("   Pin each game to its own core? (y/n): ");
+
+  // Each side of a pondering game needs a core of its own
+  config.allowPondering = false;
+  if (2 * threads <= maxThreads) {
+    config.allowPondering = getYesNoInput(
+        "   Let agents think on the opponent's time (pondering)? (y/n): ");
+  }
+  tournament_.setConfig(config);
+
+  std::cout << "   ✓ Parallel games: " << threads
+            << (config.pinThreads ? " (pinned)" : "")
+            << (config.allowPondering ? ", pondering" : "") << std::endl;
+  std::cout << std::endl;
+}
+
+void TournamentConsole::configureSandbox() {
+  auto config = tournament_.getConfig();
+  std::cout << "5. Agent Isolation" << std::endl;
+  if (!isSandboxSupported()) {
+    std::cout << "   Not supported on this platform, agents run in process"
+              << std::endl;
+    std::cout << std::endl;
+    return;
+  }
+  std::cout << "   Sandboxed agents run in their own process: a hung agent "
+               "is killed at its deadline and a crash only loses the game"
+            << std::endl;
+  config.sandboxAgents =
+      getYesNoInput("   Run each agent in its own process? (y/n): ");
+
+  config.agentMemoryLimitMB = 0;
+  if (config.sandboxAgents) {
+    std::cout << "   Enter memory limit per agent in MB (256-65536) or press "
+                 "Enter for no limit: ";
+    std::string input;
+    std::getline(std::cin, input);
+    if (!input.empty()) {
+      try {
+        int limit = std::stoi(input);
+        if (limit < 256 || limit > 65536) {
+          std::cout << "   Invalid range, using no limit" << std::endl;
+        } else {
+          config.agentMemoryLimitMB = static_cast<size_t>(limit);
+        }
+      } catch (...) {
+        std::cout << "   Invalid input, using no limit" << std::endl;
+      }
+    }
+  }
+  tournament_.setConfig(config);
+
+  std::cout << "   ✓ Agent isolation: "
+            << (config.sandboxAgents ? "separate processes" : "in process");
+  if (config.agentMemoryLimitMB > 0) {
+    std::cout << ", " << config.agentMemoryLimitMB << " MB limit";
+  }
+  std::cout << std::endl << std::endl;
+}
+
 void TournamentConsole::setupAllAgents() {
   // Clear any existing agents
   tournament_.clearAgents();
 
-  std::cout << "4. Adding All Available Agents" << std::endl;
+  std::cout << "6. Adding All Available Agents" << std::endl;
 
   // Add all available agent types
   for (const auto &agentType : availableAgentTypes_) {
@@ -319,7 +484,7 @@ void TournamentConsole::runTournament() {
   config.logGames = true;
   tournament_.setConfig(config);
 
-  std::cout << "5. Running Tournament" << std::endl;
+  std::cout << "7. Running Tournament" << std::endl;
   std::cout << "   Press Ctrl+C to interrupt (results will be saved)"
             << std::endl;
   std::cout << "   Starting in 3 seconds...";
@@ -359,7 +524,7 @@ void TournamentConsole::runTournament() {
 }
 
 void TournamentConsole::saveResultsJson() {
-  std::cout << "6. Saving Results" << std::endl;
+  std::cout << "8. Saving Results" << std::endl;
 
   // Generate timestamp-based filename
   auto now = std::chrono::system_clock::now();
@@ -493,8 +658,13 @@ void TournamentConsole::displayCurrentConfiguration() const {
 
   std::cout << "Current Configuration:" << std::endl;
   std::cout << "  Agents: " << agentNames.size() << std::endl;
-  std::cout << "  Time Limit: " << config.timeLimit.count() << "ms"
-            << std::endl;
+  if (config.gameTime.count() > 0) {
+    std::cout << "  Game Clock: " << config.gameTime.count() << "ms + "
+              << config.increment.count() << "ms per move" << std::endl;
+  } else {
+    std::cout << "  Time Limit: " << config.timeLimit.count() << "ms"
+              << std::endl;
+  }
   std::cout << "  Rounds per Matchup: " << config.roundsPerMatchup << std::endl;
 }
 